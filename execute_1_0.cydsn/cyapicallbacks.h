@@ -44,6 +44,7 @@
 	#define ADC_SAR_1_ISR_INTERRUPT_CALLBACK
 	#define isr_spi_tx_INTERRUPT_INTERRUPT_CALLBACK
 	#define isr_mot_INTERRUPT_INTERRUPT_CALLBACK
+	#define I2C_0_ISR_EXIT_CALLBACK
     
 	//And include their prototype:
 	void isr_t1_Interrupt_InterruptCallback();
@@ -58,6 +59,7 @@
 	void ADC_SAR_1_ISR_InterruptCallback();
 	void isr_spi_tx_Interrupt_InterruptCallback();
 	void isr_mot_Interrupt_InterruptCallback();
+	void I2C_0_ISR_ExitCallback();
 	//Place all the functions in isr_callback.c
     
 #endif //CYAPICALLBACKS_H  
@@ -37,6 +37,14 @@
 	
 // DEFINITIONS	
 
+//Execute only, not in flexsea-system's list:
+#ifndef CALIBRATION_COGGING
+#define CALIBRATION_COGGING 0x04
+#endif
+#ifndef CALIBRATION_MOTOR_ID
+#define CALIBRATION_MOTOR_ID 0x08
+#endif
+
 // EXTERNS
 extern uint8_t calibrationFlags, calibrationNew;
 
@@ -45,5 +53,8 @@ uint8_t isFindingPoles();
 uint8_t isFindingCurrentZeroes();
 uint8_t isRunningCalibrationProcedure();
 uint8_t isLegalCalibrationProcedure(uint8_t procedure);
+
+// TEST FUNCTIONS
+uint8_t test_legal_calibration_procedures(void);
 	
 #endif	//CALIBRATION_TOOLS_H
@@ -0,0 +1,110 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-execute' Advanced Motion Controller
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] cogging: torque ripple map (calibration & current feed-forward)
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-17 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_COGGING_H
+#define INC_COGGING_H
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include "main.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+//Uncomment to add the feed-forward to motor_current_pid_3() (the map comes
+//from CALIBRATION_COGGING):
+//#define USE_COGGING_COMP
+
+//The map is only kept in FLASH if USE_FLASH is defined (project-wide, it is
+//not by default). Without it, the map is in RAM: lost at reset, recalibrate
+//after every power cycle.
+
+//Map: current (ctrl[0].current units) indexed by as5047.ang_abs_clks
+#define COGGING_BINS_SHIFT		8
+#define COGGING_BINS			(1 << COGGING_BINS_SHIFT)
+#define COGGING_BIN_SHIFT		(14 - COGGING_BINS_SHIFT)	//64 counts per bin
+
+//Calibration (1kHz): slow sweep forward then back, position PI, voltage out
+#define COGGING_SPEED			2			//counts/ms, ~8s per turn
+#define COGGING_REVS			2			//Turns per direction
+#define COGGING_SETTLE_MS		500			//Hold before the first sweep
+#define COGGING_SKIP_MS			250			//Not recorded after a start/reversal
+#define COGGING_SWEEP			((int32_t)COGGING_REVS * 16384 + COGGING_SPEED * COGGING_SKIP_MS)
+#define COGGING_KP				2			//mV/count
+#define COGGING_KI				1			//mV/(count*ms) >> COGGING_KI_SHIFT
+#define COGGING_KI_SHIFT		3
+#define COGGING_MAX_ERR_SUM		80000		//counts*ms
+#define COGGING_MAX_ERR			2000		//counts, aborts if it can't follow
+
+//Storage (USE_FLASH): save_angles_to_flash(), COGGING_FLASH_CHUNK words in
+//arrays 0-2, map then COGGING_MAGIC
+#define COGGING_FLASH_CHUNK		100
+#define COGGING_FLASH_WORDS		(COGGING_BINS + 1)
+#define COGGING_MAGIC			0xC066
+
+//coggingCal.state:
+#define COG_IDLE				0
+#define COG_SETTLE				1
+#define COG_FWD					2
+#define COG_REV					3
+#define COG_DONE				4
+
+//****************************************************************************
+// Structure(s)
+//****************************************************************************
+
+struct cogging_s
+{
+	int16_t map[COGGING_BINS];			//Zero mean
+	uint8_t valid;						//Calibrated, or loaded from flash (USE_FLASH)
+	uint8_t state;
+	int16_t peak;						//Largest |map[]|
+	int16_t friction;					//Half the forward/reverse difference
+	uint8_t aborted;					//Last calibration couldn't follow
+};
+
+//****************************************************************************
+// Shared variable(s)
+//****************************************************************************
+
+extern struct cogging_s coggingCal;
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+void init_cogging(void);
+uint8_t cogging_calibration(void);
+int32_t cogging_ff(int32_t ang);
+
+#endif	//INC_COGGING_H
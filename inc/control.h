@@ -44,6 +44,7 @@
 
 extern struct ctrl_s ctrl[2];
 extern struct in_control_s in_control;
+extern struct current_bench_s currentLoopBench;
 	
 //****************************************************************************
 // Prototype(s):
@@ -55,9 +56,11 @@ int32 motor_position_pid(int32 wanted_pos, int32 actual_pos, uint8_t ch);
 int32 motor_position_pid_ff_1(int32 wanted_pos, int32 actual_pos, int32 ff, uint8_t ch);
 int32 motor_current_pid(int32 wanted_curr, int32 measured_curr, uint8_t ch);
 int32 motor_current_pid_3(int32 wanted_curr, int32 measured_curr, uint8_t ch);
+void current_loop_isr(void);
 void impedance_controller(uint8_t ch);
 void in_control_combine(void);
 void in_control_get_pwm_dir(void);
+void current_loop_benchmark(void);
 
 //****************************************************************************
 // Definition(s):
@@ -77,6 +80,31 @@ void in_control_get_pwm_dir(void);
 #define CURRENT_NEG_LIMIT		(-CURRENT_SPAN)
 #define MAX_CUM_CURRENT_ERROR	100000
 
+//Uncomment to run motor_current_pid_3() in the SPI ISR (PWM synchronous)
+//instead of the 10kHz FSM. Sample -> PI -> commutation in one pass.
+//Not used with USE_FOC (already in the ISR).
+//#define CURRENT_LOOP_IN_ISR
+
+//ISR current loop rate: PWM_FREQ_HZ >> CURRENT_LOOP_DIV_SHIFT (0: 20kHz,
+//1: 10kHz, 2: 5kHz). The gains keep the same meaning at every rate.
+#ifndef CURRENT_LOOP_DIV_SHIFT
+#define CURRENT_LOOP_DIV_SHIFT	0
+#endif
+
+#ifdef CURRENT_LOOP_IN_ISR
+#define CURRENT_LOOP_HZ			(PWM_FREQ_HZ >> CURRENT_LOOP_DIV_SHIFT)
+#define CURRENT_KI_SHIFT		(14 - CURRENT_LOOP_DIV_SHIFT)
+#define CURRENT_ISR_AVG_SHIFT	2					//Moving average, 4 samples
+#else
+#define CURRENT_LOOP_HZ			10000				//mainFSM10kHz()
+#define CURRENT_KI_SHIFT		13
+#endif	//CURRENT_LOOP_IN_ISR
+
+//Same integral limit (in mV) at every rate:
+#define CURRENT_MAX_ERR_SUM		((MAX_CUM_CURRENT_ERROR / 10000) * CURRENT_LOOP_HZ)
+
+#define CURRENT_BENCH_N			4096				//current_loop_benchmark()
+
 //Nickname for the controller gains:
 #define I_KP					g0
 #define I_KI					g1
@@ -104,4 +132,12 @@ void in_control_get_pwm_dir(void);
 // Structure(s)
 //****************************************************************************	
 
+//current_loop_benchmark(), in CPU cycles (BCLK__BUS_CLK__HZ)
+struct current_bench_s
+{
+	uint32_t isrCycles;			//Current arrays & commutation, every PWM period
+	uint32_t piCycles;			//motor_current_pid_3()
+	uint16_t loadPerMil[3];		//CURRENT_LOOP_DIV_SHIFT = 0, 1, 2
+};
+
 #endif	//INC_MOTOR_H
@@ -35,6 +35,7 @@
 //****************************************************************************	
 
 #include "main.h"
+#include "ringbuf.h"
 //#include <flexsea_user_structs.h>
 
 //****************************************************************************
@@ -47,6 +48,7 @@ void update_current_arrays(void);
 void set_current_zero(void);
 void get_phase_currents(int32_t *);
 void adc_sar2_dma_reinit(void);
+void current_recip_benchmark(void);
 
 //****************************************************************************
 // Definition(s):
@@ -56,12 +58,33 @@ void adc_sar2_dma_reinit(void);
 #define ADC2_BUF_LEN				9
 #define ADC2_BUF_LEN_3RD			3
 
+//ADC_SAR_2 converts C, A, B, one channel per PWM period; the DMA interrupt
+//(sampleStamp.adc) comes with B. Age of each phase sample at that time, us:
+#ifndef ADC2_SAMPLE_SPACING_US
+#define ADC2_SAMPLE_SPACING_US		PWM_PERIOD_US
+#endif
+#define ADC2_AGE_A_US				ADC2_SAMPLE_SPACING_US
+#define ADC2_AGE_B_US				0
+#define ADC2_AGE_C_US				(2 * ADC2_SAMPLE_SPACING_US)
+
+//Motor current average (ctrl[0].current.actual_vals.avg), ISR samples
+#define CURRENT_AVG_WINDOW			50
+
 //DMA ADC SAR 2
 #define DMA_1_BYTES_PER_BURST 		2
 #define DMA_1_REQUEST_PER_BURST 	1
 #define DMA_1_SRC_BASE 				(CYDEV_PERIPH_BASE)
 #define DMA_1_DST_BASE 				(CYDEV_SRAM_BASE)
 
+//Comment to go back to the divisions in update_current_arrays() (sine):
+#define USE_CURRENT_RECIP
+
+//Reciprocals (RECIP_U32()): |raw| * PCOM_G < 2^22 with |com| <= PWM_AMP (9
+//bits), |vel * lead| < 2^31 with 1000 (10 bits)
+#define PCOM_RECIP_SHIFT			31
+#define DIV1000_SHIFT				41
+#define CURR_RECIP_BENCH_N			4096
+
 //Sine Commut constants:
 //Unclear why I need different values... but currently required
 #ifdef BOARD_SUBTYPE_RIGID
@@ -80,9 +103,21 @@ extern int16 adc_dma_array[ADC2_BUF_LEN];
 extern int16 adc_dma_array_buf[ADC2_BUF_LEN];
 extern volatile uint8_t current_sensing_flag;
 extern volatile int hallCurr;
+extern int32_t phase_a_zero, phase_b_zero, phase_c_zero;
+extern struct ringbuf_s currentRing;
+extern struct curr_recip_bench_s currRecipBench;
 
 //****************************************************************************
 // Structure(s):
 //****************************************************************************
 
+//current_recip_benchmark(): cycles per sample, and differences with the
+//divisions (all phase values, random samples)
+struct curr_recip_bench_s
+{
+	uint32_t divCycles, recipCycles;
+	uint32_t pcomChecked, pcomErrors;
+	uint32_t samples, sampleErrors;
+};
+
 #endif	//INC_CURRENT_SENSING_H
@@ -0,0 +1,124 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-execute' Advanced Motion Controller
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] datalog: triggered high-rate logger (SPI ISR), RAM buffer
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-17 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_DATALOG_H
+#define INC_DATALOG_H
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include "main.h"
+#include "flexsea_comm_multi.h"
+#include "flexsea_sys_def.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+//Comment to remove the logger from the SPI ISR:
+#define USE_DATALOG
+
+#define DATALOG_LEN				512		//Samples, power of 2 (8kB)
+#define DATALOG_MASK			(DATALOG_LEN - 1)
+#define DATALOG_READ_SAMPLES	3		//Per reply
+
+//States:
+#define DATALOG_IDLE			0
+#define DATALOG_ARMED			1		//Filling the pre-trigger window
+#define DATALOG_TRIGGERED		2		//Filling the post-trigger window
+#define DATALOG_DONE			3		//Ready to be read
+
+//Trigger sources (the command can always force a trigger):
+#define DATALOG_TRIG_MANUAL		0
+#define DATALOG_TRIG_ERR		1		//|current error| >= threshold
+#define DATALOG_TRIG_CURR		2		//|current| >= threshold
+
+//Multi-packet command (read), allocated in flexsea_sys_def.h (flexsea-system):
+#ifndef CMD_DATALOG
+#error "CMD_DATALOG missing: update flexsea-system"
+#endif
+
+//Request [0]:
+#define DATALOG_REQ_NEXT		0		//Next block of samples (streaming)
+#define DATALOG_REQ_ARM			1		//[1] source, [2-5] threshold,
+										//[6-7] pre-trigger, [8] decimation
+#define DATALOG_REQ_TRIGGER		2
+#define DATALOG_REQ_STOP		3
+#define DATALOG_REQ_READ		4		//[1-2] first sample
+
+//****************************************************************************
+// Structure(s)
+//****************************************************************************
+
+//One ISR call. Currents in ADC counts (zero removed), PWM compare values.
+struct datalog_sample_s
+{
+	int16_t ia, ib, ic;
+	uint16_t pwm[3];
+	uint16_t ang;					//as5047.ang_comp_clks
+	int16_t err;					//Current loop error, saturated
+};
+
+struct datalog_s
+{
+	volatile uint8_t state;
+	volatile uint8_t force;
+	uint8_t source;
+	uint8_t decim, decimCnt;
+	int32_t threshold;
+	uint16_t pre;					//Samples before the trigger
+	uint16_t filled;
+	uint16_t post;					//Samples left after the trigger
+	uint16_t head;					//Next write
+	uint16_t start;					//Oldest sample, once DATALOG_DONE
+	struct datalog_sample_s buf[DATALOG_LEN];
+};
+
+//****************************************************************************
+// Shared variable(s)
+//****************************************************************************
+
+extern struct datalog_s datalog;
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+void initDatalog(void);
+void datalog_arm(uint8_t source, int32_t threshold, uint16_t pre, uint8_t decim);
+void datalog_trigger(void);
+void datalog_stop(void);
+void datalog_isr(void);
+uint8_t datalog_read(uint16_t first, uint8_t n, uint8_t *buf, uint16_t *index);
+void rx_multi_cmd_datalog_rr(uint8_t *msgBuf, MultiPacketInfo *info, \
+								uint8_t *responseBuf, uint16_t* responseLen);
+
+#endif	//INC_DATALOG_H
@@ -39,22 +39,54 @@
 #include "flexsea_global_structs.h"
 
 //****************************************************************************
-// Prototype(s):
+// Definition(s):
 //****************************************************************************
 
-int32_t filt_array_10khz(int64_t *,int64_t *,int,int64_t);
-int32_t filt_array_1khz(int64_t *,int64_t *,int,int64_t);
-int32_t filt_array_250hz(int64_t *,int64_t *,int,int64_t);
-int get_median(int, int, int);
-void filt_array_1khz_struct(struct filtvar_s *, int);
+//Compile-time coefficients. FILT_K() is tan(pi*fc/fs) (bilinear transform
+//prewarping) as a series, good to 1e-7 up to fc = fs/5. All the macros
+//below are constant expressions: no floating point at runtime.
+#define FILT_PI					3.14159265358979
+#define FILT_TAN(x)				((x) * (1.0 + (x)*(x) * (1.0/3 + (x)*(x) * (2.0/15 + \
+								(x)*(x) * (17.0/315 + (x)*(x) * (62.0/2835 + \
+								(x)*(x) * (1382.0/155925 + (x)*(x) * (21844.0/6081075))))))))
+#define FILT_K(fc, fs)			FILT_TAN(FILT_PI * (double)(fc) / (double)(fs))
+#define FILT_ROUND(v)			((int32_t)((v) + (((v) >= 0) ? 0.5 : -0.5)))
+#define FILT_Q(v, q)			FILT_ROUND((v) * (double)(1LL << (q)))
 
-int32_t get_accl_1k_5samples_downsampled(struct diffarr_s *);
-int32_t get_vel_1k_5samples(struct diffarr_s *);
-int32_t get_vel_1k_5samples_downsampled(struct diffarr_s *);
+//1st order Butterworth LPF: y = b*(x + x1) - a*y1
+#define LPF1_B(fc, fs)			(FILT_K(fc, fs) / (1.0 + FILT_K(fc, fs)))
+#define LPF1_A(fc, fs)			((FILT_K(fc, fs) - 1.0) / (FILT_K(fc, fs) + 1.0))
 
-//****************************************************************************
-// Definition(s):
-//****************************************************************************
+//2nd order Butterworth LPF (Q = 1/sqrt(2)):
+#define BQ_NORM(fc, fs)			(1.0 / (1.0 + 1.41421356237310 * FILT_K(fc, fs) + \
+								FILT_K(fc, fs) * FILT_K(fc, fs)))
+#define BQ_LPF_B0(fc, fs)		(FILT_K(fc, fs) * FILT_K(fc, fs) * BQ_NORM(fc, fs))
+#define BQ_LPF_A1(fc, fs)		(2.0 * (FILT_K(fc, fs) * FILT_K(fc, fs) - 1.0) * BQ_NORM(fc, fs))
+#define BQ_LPF_A2(fc, fs)		((1.0 - 1.41421356237310 * FILT_K(fc, fs) + \
+								FILT_K(fc, fs) * FILT_K(fc, fs)) * BQ_NORM(fc, fs))
+
+//Filter objects: coefficients in Q30, 32-bit state, 64-bit accumulator
+//(SMLAL). Inputs must stay within +/-2^28. Biquads: fc >= fs/2000.
+#define FILT_COEF_Q				30
+#define LPF1_INIT(fc, fs)		{FILT_Q(LPF1_B(fc, fs), FILT_COEF_Q), \
+								FILT_Q(LPF1_A(fc, fs), FILT_COEF_Q), 0, 0, 0}
+#define BIQUAD_LPF_INIT(fc, fs)	{FILT_Q(BQ_LPF_B0(fc, fs), FILT_COEF_Q), \
+								FILT_Q(2.0 * BQ_LPF_B0(fc, fs), FILT_COEF_Q), \
+								FILT_Q(BQ_LPF_B0(fc, fs), FILT_COEF_Q), \
+								FILT_Q(BQ_LPF_A1(fc, fs), FILT_COEF_Q), \
+								FILT_Q(BQ_LPF_A2(fc, fs), FILT_COEF_Q), 0, 0, 0, 0, 0, 0}
+
+//Cut-off tables, 1 to 50Hz: FILT_FC_1_50(X, fs, q) expands X(fc, fs, q)
+#define FILT_FC_10(X, d, fs, q)	X(d+1, fs, q) X(d+2, fs, q) X(d+3, fs, q) X(d+4, fs, q) \
+								X(d+5, fs, q) X(d+6, fs, q) X(d+7, fs, q) X(d+8, fs, q) \
+								X(d+9, fs, q) X(d+10, fs, q)
+#define FILT_FC_1_50(X, fs, q)	FILT_FC_10(X, 0, fs, q) FILT_FC_10(X, 10, fs, q) \
+								FILT_FC_10(X, 20, fs, q) FILT_FC_10(X, 30, fs, q) \
+								FILT_FC_10(X, 40, fs, q)
+#define FILT_TABLE_A(fc, fs, q)	FILT_Q(LPF1_A(fc, fs), q),
+#define FILT_TABLE_B(fc, fs, q)	FILT_Q(LPF1_B(fc, fs), q),
+
+#define FILT_BENCH_N			2000		//filters_benchmark()
 
 //Motor current ADC:
 
@@ -62,9 +94,54 @@ int32_t get_vel_1k_5samples_downsampled(struct diffarr_s *);
 // Shared variable(s)
 //****************************************************************************	
 
+extern struct filt_bench_s filtBench;
+
 
 //****************************************************************************
 // Structure(s):
 //****************************************************************************
 
+struct lpf1_s
+{
+	int32_t b, a;					//Q30
+	int32_t x1, y1;
+	int32_t err;					//Error feedback (truncated fraction)
+};
+
+struct biquad_s
+{
+	int32_t b0, b1, b2, a1, a2;		//Q30, a0 = 1
+	int32_t x1, x2, y1, y2;
+	int32_t err1, err2;				//2nd order error feedback
+};
+
+//filters_benchmark(): CPU cycles per call, worst error vs a double
+//precision filter in 1/1000 of an output LSB
+struct filt_bench_s
+{
+	uint32_t legacyCycles, lpf1Cycles, biquadCycles;
+	uint32_t legacyErr, lpf1Err, biquadErr;
+};
+
+//****************************************************************************
+// Prototype(s):
+//****************************************************************************
+
+int32_t filt_array_10khz(int64_t *,int64_t *,int,int64_t);
+int32_t filt_array_1khz(int64_t *,int64_t *,int,int64_t);
+int32_t filt_array_250hz(int64_t *,int64_t *,int,int64_t);
+int get_median(int, int, int);
+void filt_array_1khz_struct(struct filtvar_s *, int);
+
+int32_t get_accl_1k_5samples_downsampled(struct diffarr_s *);
+int32_t get_vel_1k_5samples(struct diffarr_s *);
+int32_t get_vel_1k_5samples_downsampled(struct diffarr_s *);
+
+void lpf1_reset(struct lpf1_s *f, int32_t x);
+int32_t lpf1_run(struct lpf1_s *f, int32_t x);
+void biquad_reset(struct biquad_s *f, int32_t x);
+int32_t biquad_run(struct biquad_s *f, int32_t x);
+
+void filters_benchmark(void);
+
 #endif	//INC_FILTERS_H
@@ -0,0 +1,74 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-execute' Advanced Motion Controller
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] fixed_math: integer trigonometry (no FPU on the Cortex-M3)
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-17 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_FIXED_MATH_H
+#define INC_FIXED_MATH_H
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include "main.h"
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+int16_t sin_q15(uint16_t ang);
+int16_t cos_q15(uint16_t ang);
+uint16_t ratio_to_ang16(int32_t t, int32_t period);
+uint16_t sqrt_u32(uint32_t x);
+
+void fixed_math_sin_test_code_blocking(void);
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+//Angles: 16 bits = 1 turn. Results: Q15, 32767 = 1.0
+#define ANG16_TURN				65536
+#define ANG16_QUARTER			16384
+#define Q15_ONE					32767
+#define Q15_SQRT3_2				28378	//sqrt(3)/2
+
+#define SIN_Q15_TABLE_BITS		8		//257 entries per quarter wave
+
+//Division by a reciprocal: n / d = (n * RECIP_U32(d, s)) >> s, exact (same
+//as the integer division) for 0 <= n < 2^(s - ceil(log2(d))).
+#define RECIP_U32(d, s)			((uint32_t)((((uint64_t)1 << (s)) + (d) - 1) / (d)))
+#define RECIP_DIV(n, r, s)		((uint32_t)(((uint64_t)(n) * (r)) >> (s)))
+
+//****************************************************************************
+// Shared variable(s)
+//****************************************************************************
+
+extern const int16_t sinQ15Table[(1 << SIN_Q15_TABLE_BITS) + 1];
+
+#endif	//INC_FIXED_MATH_H
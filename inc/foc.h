@@ -0,0 +1,99 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-execute' Advanced Motion Controller
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] foc: Field Oriented Control current loop (sine commutation)
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-17 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_FOC_H
+#define INC_FOC_H
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include "main.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+//Uncomment to replace motor_current_pid_3() by the FOC current loop. Same
+//gains (I_KP, I_KI) and current units.
+//#define USE_FOC
+
+//Phase current, ADC counts to mA (positive current = lower reading)
+#define FOC_MA_PER_LSB			16
+
+//PI: v[mV] = (I_KP * err) >> 8 + (I_KI * sum(err)) >> 14. The loop runs at
+//20kHz, twice the rate of motor_current_pid_3() (>> 13 at 10kHz).
+#define FOC_KP_SHIFT			8
+#define FOC_KI_SHIFT			14
+#define FOC_MAX_ERR_SUM			200000
+
+//Voltage vector limit, in sensor_sin_commut() units (1024 = PWM_AMP).
+//SVPWM & THI reach 2/sqrt(3) before clipping.
+#define FOC_PWM_MAX_SINE		1024
+#define FOC_PWM_MAX_SVPWM		1182
+
+//foc_limit() return value, axes that were clipped:
+#define FOC_SAT_D				0x01
+#define FOC_SAT_Q				0x02
+
+//****************************************************************************
+// Structure(s)
+//****************************************************************************
+
+//Currents are in the motor_current_pid_3() units: 3/2 x phase amplitude, mA
+struct foc_s
+{
+	uint8_t enabled;
+	int32_t idRef, iqRef;
+	int32_t id, iq;
+	int32_t dErrSum, qErrSum;
+	int32_t vd, vq;				//mV, setMotorVoltage() scale
+	int32_t pwmPerMv;			//Q16, 577/Vb
+	int32_t pwmD, pwmQ;			//After the limit, 1024 = PWM_AMP
+};
+
+//****************************************************************************
+// Shared variable(s)
+//****************************************************************************
+
+extern struct foc_s foc;
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+void foc_set_current(int32_t iq, int32_t id);
+void foc_disable(void);
+void foc_current_loop(uint16_t angSample, uint16_t angOutput);
+void foc_clarke_park(int32_t ia, int32_t ib, int32_t ic, uint16_t elecAng, \
+						int32_t *d, int32_t *q);
+void foc_inv_park_pwm(int32_t d, int32_t q, uint16_t elecAng, uint16_t *pwm);
+
+#endif	//INC_FOC_H
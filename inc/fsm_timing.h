@@ -0,0 +1,149 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-execute' Advanced Motion Controller
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] fsm_timing: execution time statistics for the main FSM slots
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-17 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_FSM_TIMING_H
+#define INC_FSM_TIMING_H
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include "main.h"
+#include "flexsea_comm_multi.h"
+#include "flexsea_sys_def.h"
+
+#ifdef SIM_HOST
+#include "sim_hal.h"
+#endif	//SIM_HOST
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+//Comment to remove the instrumentation from the main loop:
+#define USE_FSM_TIMING
+
+#define FSM_TIMING_SLOTS		12		//mainFSM0-9, mainFSM10kHz, SPI ISR
+#define FSM_TIMING_10KHZ		10
+#define FSM_TIMING_ISR			11		//AS5047 read done: commutation & current
+//ISR budget: half of the 20kHz PWM period (the SPI transfer uses the rest)
+#define FSM_TIMING_ISR_BUDGET	(BCLK__BUS_CLK__HZ / 40000)
+#define FSM_TIMING_BINS			16		//log2(cycles), last bin >= 32768
+#define FSM_TIMING_P99_STEP		4		//cycles
+
+//Multi-packet command (read), allocated in flexsea_sys_def.h (flexsea-system):
+#ifndef CMD_FSM_TIMING
+#error "CMD_FSM_TIMING missing: update flexsea-system"
+#endif
+
+//Request: [0] = 0 to cycle through the slots (streaming), n for slot n-1.
+//Set FSM_TIMING_REQ_RESET to clear the statistics after the reply.
+#define FSM_TIMING_REQ_RESET	0x80
+
+//Cycle counter (DWT, Cortex-M3). The host simulation uses the PC's clock.
+#ifdef SIM_HOST
+#define FSM_TIMING_NOW()		simHalCycleCount()
+#else
+#define DEMCR_REG				(*(reg32 *)0xE000EDFCu)
+#define DWT_CTRL_REG			(*(reg32 *)0xE0001000u)
+#define DWT_CYCCNT_REG			(*(reg32 *)0xE0001004u)
+#define DEMCR_TRCENA			0x01000000u
+#define DWT_CTRL_CYCCNTENA		0x00000001u
+#define FSM_TIMING_NOW()		(DWT_CYCCNT_REG)
+#endif	//SIM_HOST
+
+//Sample timestamps: same free-running counter, differences in us (signed,
+//+/- 26s at the 80MHz BCLK__BUS_CLK__HZ). The host simulation uses its
+//virtual time.
+#ifdef SIM_HOST
+#define STAMP_NOW()				simHalStampCycles()
+#else
+#define STAMP_NOW()				(DWT_CYCCNT_REG)
+#endif	//SIM_HOST
+#define STAMP_DIFF_US(a, b)		((int32_t)((a) - (b)) / (int32_t)(BCLK__BUS_CLK__HZ / 1000000u))
+
+#ifdef USE_FSM_TIMING
+#define FSM_TIMING_START(t)			uint32_t t = FSM_TIMING_NOW()
+#define FSM_TIMING_STOP(slot, t)	fsmTimingStore((slot), FSM_TIMING_NOW() - (t))
+#define FSM_TIMING_STOP_ISR(t)		fsmTimingStoreIsr(FSM_TIMING_NOW() - (t))
+#else
+#define FSM_TIMING_START(t)
+#define FSM_TIMING_STOP(slot, t)
+#define FSM_TIMING_STOP_ISR(t)
+#endif	//USE_FSM_TIMING
+
+//****************************************************************************
+// Structure(s)
+//****************************************************************************
+
+//All times in CPU cycles (BCLK__BUS_CLK__HZ)
+struct fsm_timing_s
+{
+	uint32_t min, max;
+	uint64_t sum;
+	uint32_t count;
+	uint32_t p99;						//Running estimate
+	uint16_t overruns;					//Next tick came before we were done
+										//(ISR: over FSM_TIMING_ISR_BUDGET)
+	uint16_t hist[FSM_TIMING_BINS];
+};
+
+//Capture times (STAMP_NOW()) of the samples used by the commutation
+struct sample_stamp_s
+{
+	uint32_t ang;						//AS5047 angle (end of the SPI read)
+	uint32_t adc;						//ADC_SAR_2 sequence (DMA interrupt)
+	uint32_t pwm;						//PWM A reload (isr_mot)
+};
+
+//****************************************************************************
+// Shared variable(s)
+//****************************************************************************
+
+extern struct fsm_timing_s fsmTiming[FSM_TIMING_SLOTS];
+extern volatile struct sample_stamp_s sampleStamp;
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+void initFsmTiming(void);
+void fsmTimingReset(void);
+void fsmTimingStore(uint8_t slot, uint32_t cycles);
+void fsmTimingStoreIsr(uint32_t cycles);
+void fsmTimingCheckOverrun(uint8_t slot);
+uint32_t fsmTimingMean(uint8_t slot);
+uint32_t fsmTimingNowUs(void);
+uint16_t fsmTimingCpuLoad(uint8_t slot);
+uint16_t fsmTimingCpuLoadTotal(void);
+void rx_multi_cmd_fsm_timing_rr(uint8_t *msgBuf, MultiPacketInfo *info, \
+								uint8_t *responseBuf, uint16_t* responseLen);
+
+#endif	//INC_FSM_TIMING_H
@@ -38,36 +38,92 @@
 #include "main.h"
 
 //****************************************************************************
-// Shared variable(s)
+// Definition(s):
 //****************************************************************************
 
-extern uint8_t i2c_last_request;
-extern volatile uint8_t i2c_0_r_buf[24];
+//I2C0 transaction queue. Devices register periodic reads (their own rate &
+//decoder), the ISR chains them back-to-back. One-shot transfers (writes,
+//blocking reads) go first.
+#define I2C0_MAX_TASKS			6
+#define I2C0_BUF_LEN			72			//IMU FIFO: 5 samples
+#define I2C0_START_RETRIES		5			//One-shot, bus not ready
+#define I2C0_RETRY_US			100			//Blocking read: retry period
+
+//Blocking read timeout: its own transfer, after the one in progress (up to
+//I2C0_BUF_LEN bytes), plus the start retries. 100kHz worst case, 9 bits/byte.
+#define I2C0_BYTE_US			90
+#define I2C0_XFER_US(n)			(((n) + 3) * I2C0_BYTE_US)	//Address, register, restart
+#define I2C0_TIMEOUT_US(n)		(I2C0_XFER_US(n) + I2C0_XFER_US(I2C0_BUF_LEN) + \
+								I2C0_START_RETRIES * I2C0_RETRY_US)
+
+//Periodic reads, in i2c_0_fsm() ticks (1ms). 0: on demand, i2c0_trigger().
+#define I2C0_PERIOD_IMU			4
+#define I2C0_PERIOD_AS5048B		1
+#define I2C0_PERIOD_EXT_STRAIN	4
+
+//Transfer types:
+#define I2C_XFER_READ			0			//Register address, restart, read
+#define I2C_XFER_WRITE			1
+
+//Queue states:
+#define I2C_Q_IDLE				0
+#define I2C_Q_REG				1			//Register address, no stop
+#define I2C_Q_READ				2
+#define I2C_Q_WRITE				3
+
+//i2c0_read() return values:
+#define I2C0_READ_OK			0
+#define I2C0_READ_BUSY			1
+#define I2C0_READ_TIMEOUT		2
+#define I2C0_READ_ERROR			3
 
 //****************************************************************************
-// Public Function Prototype(s):
+// Structure(s)
 //****************************************************************************
 
-void i2c_0_fsm(void);
-void init_i2c_0(void);
-void init_i2c_1(void);
-int i2c0_read(uint8_t slave_addr, uint8_t reg_addr, uint8_t *pdata, uint16 length);
-uint8_t I2C_0_MasterWriteByteTimeOut(uint8_t theByte, uint32 timeout);
-void assign_i2c_data(uint8_t *newdata);
+struct i2c_xfer_s
+{
+	uint8_t type;
+	uint8_t addr, reg, len;
+	uint8_t buf[I2C0_BUF_LEN];			//Read data, or bytes to write
+	uint8_t period, countdown;			//Periodic reads, ticks (0: on demand)
+	volatile uint8_t pending;			//Cleared when the transfer is done
+	uint8_t retries;					//One-shot: failed starts
+	uint16_t errors;
+	void (*done)(uint8_t *buf);			//Decoder, called from the ISR
+};
+
+struct i2c_queue_s
+{
+	struct i2c_xfer_s task[I2C0_MAX_TASKS];
+	struct i2c_xfer_s oneShot;
+	uint8_t taskCnt;
+	volatile uint8_t state;
+	struct i2c_xfer_s * volatile current;
+	uint32_t transfers;
+	uint16_t errors;
+	uint16_t overruns;					//Read still pending at its next period
+};
 
 //****************************************************************************
-// Definition(s):
+// Shared variable(s)
 //****************************************************************************
 
-//ISR reading of I2C0 sensors (IMU, Strain Gauge, AS5048B, etc.):
-#define I2C_RQ_GYRO				1
-#define I2C_RQ_ACCEL			2
-#define I2C_RQ_AS5048B			3
-#define I2C_RQ_EXT_STRAIN		4
+extern struct i2c_queue_s i2c0q;
 
 //****************************************************************************
-// Structure(s)
+// Public Function Prototype(s):
 //****************************************************************************
 
+void i2c_0_fsm(void);
+void init_i2c_0(void);
+void init_i2c_1(void);
+int8_t i2c0_register(uint8_t addr, uint8_t reg, uint8_t len, uint8_t period, \
+						void (*done)(uint8_t *buf));
+uint8_t i2c0_trigger(int8_t task, uint8_t len);
+uint8_t i2c0_write(uint8_t slave_addr, uint8_t *pdata, uint8_t length);
+int i2c0_read(uint8_t slave_addr, uint8_t reg_addr, uint8_t *pdata, uint16 length);
+void i2c0_isr(void);
+uint8_t I2C_0_MasterWriteByteTimeOut(uint8_t theByte, uint32 timeout);
 
 #endif	//INC_I2C_H
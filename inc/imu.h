@@ -42,6 +42,8 @@
 //****************************************************************************	
 	
 extern struct imu_s imu;
+extern int16_t imuTemp;
+extern struct imu_fifo_s imuFifo;
 	
 //****************************************************************************
 // Define Flag(s):
@@ -50,6 +52,10 @@ extern struct imu_s imu;
 //set to 1 if we want to use blocking read/write
 #define IMU_BLOCKING 	1
 
+//Uncomment to read every 1kHz sample through the IMU FIFO (timestamped, see
+//imu_fifo_pop()) instead of polling the data registers at 250Hz:
+//#define USE_IMU_FIFO
+
 //****************************************************************************
 // Definition(s):
 //****************************************************************************
@@ -66,10 +72,12 @@ typedef enum {
 //#define IMU_ADDR 0x68 //0b1101000
 #define IMU_ADDR 				0x68 	//device address of the IMU, 7bits right justified
 #define IMU_MAX_BUF_SIZE 		100 	//(in bytes) (somewhat arbitrary)
+#define IMU_BURST_LEN			14		//Accel, temperature & gyro (59-72)
 
 // IMU Register Addresses (names correspond to those in the datasheet)
 // These are internal to the imu.
 /// Config Regs
+#define IMU_SMPLRT_DIV			25
 #define IMU_CONFIG 				26
 #define IMU_GYRO_CONFIG 		27
 #define IMU_ACCEL_CONFIG		28
@@ -89,12 +97,15 @@ typedef enum {
 #define IMU_ACCEL_YOUT_L		62
 #define IMU_ACCEL_ZOUT_H		63
 #define IMU_ACCEL_ZOUT_L		64
+#define IMU_TEMP_OUT_H			65
+#define IMU_TEMP_OUT_L			66
 #define IMU_GYRO_XOUT_H			67
 #define IMU_GYRO_XOUT_L			68
 #define IMU_GYRO_YOUT_H			69
 #define IMU_GYRO_YOUT_L			70
 #define IMU_GYRO_ZOUT_H			71
 #define IMU_GYRO_ZOUT_L			72
+#define IMU_FIFO_COUNT_H		114
 #define IMU_FIFO_COUNT_L		115
 #define IMU_FIFO_R_W			116
 
@@ -114,6 +125,19 @@ typedef enum {
 ///  Accel: 460Hz bandwidth, 1.94ms delay, 220ug/rtHz noise density, 1kHz rate
 #define D_IMU_ACCEL_CONFIG2		0x0		//0b00000000
 
+// FIFO mode: 1kHz samples (DLPF 184Hz), accel + temperature + gyro, in the
+// same order as the data registers (IMU_BURST_LEN bytes per sample)
+#define D_IMU_CONFIG_FIFO		0x01	//FIFO_MODE = 0 (overwrite), DLPF_CFG = 1
+#define D_IMU_SMPLRT_DIV		0x00	//1kHz / (1 + 0)
+#define D_IMU_FIFO_EN			0xF8	//TEMP, XG, YG, ZG, ACCEL
+#define D_USER_CTRL_FIFO_EN		0x40
+#define D_USER_CTRL_FIFO_RST	0x04
+#define IMU_FIFO_SIZE			512		//bytes
+#define IMU_FIFO_PERIOD_US		1000
+#define IMU_FIFO_MAX_BATCH		5		//Samples per read (I2C0_BUF_LEN)
+#define IMU_FIFO_QUEUE_LEN		32		//Power of 2
+#define IMU_FIFO_QUEUE_MASK		(IMU_FIFO_QUEUE_LEN - 1)
+
 // IMU Reset Register Values (bits auto clear)
 #define D_SIG_COND_RST			0x1		//write to USER_CTRL: reset signal paths + clear regs
 #define D_SIGNAL_PATH_RESET		0x07	//write to SIGNAL_PATH_RESET: reset signal paths only
@@ -137,6 +161,33 @@ typedef enum {
 
 
 		
+//****************************************************************************
+// Structure(s):
+//****************************************************************************
+
+//One IMU FIFO sample. timestamp: fsmTimingNowUs() scale.
+struct imu_sample_s
+{
+	uint32_t timestamp;
+	int16_t accel[3];
+	int16_t gyro[3];
+	int16_t temp;
+};
+
+//Filled from the I2C0 ISR, emptied by imu_fifo_pop() (user_fsm())
+struct imu_fifo_s
+{
+	struct imu_sample_s q[IMU_FIFO_QUEUE_LEN];
+	volatile uint8_t head, tail;
+	int8_t readTask;					//I2C0 queue, on demand
+	uint8_t batch;						//Samples in the current read
+	uint16_t backlog;					//Samples in the IMU FIFO at countUs
+	uint32_t countUs;
+	uint32_t samples;
+	uint16_t dropped;					//Our queue was full
+	uint16_t resets;					//IMU FIFO overflows
+};
+
 //****************************************************************************
 // Prototype(s):
 //****************************************************************************
@@ -150,6 +201,13 @@ int16 get_gyro_x(void);					//Xgyro data
 int16 get_gyro_y(void);					//Ygyro data
 int16 get_gyro_z(void);					//Zgyro data
 void get_gyro_xyz(void);
+void get_imu_burst(void);
+void imu_accel_decode(uint8_t *buf);
+void imu_gyro_decode(uint8_t *buf);
+void imu_burst_decode(uint8_t *buf);
+void imu_fifo_count_decode(uint8_t *buf);
+void imu_fifo_data_decode(uint8_t *buf);
+uint8_t imu_fifo_pop(struct imu_sample_s *s);
 void reset_imu(void);					//reset IMU registers to default
 void disable_imu(void);					//disable the IMU by shutting down clocks, etc.
 
@@ -157,8 +215,4 @@ void disable_imu(void);					//disable the IMU by shutting down clocks, etc.
 int imu_write(uint8_t internal_reg_addr, uint8_t* pData, uint16 length);
 void imu_test_code_blocking(void);
 
-//****************************************************************************
-// Structure(s):
-//****************************************************************************
-
 #endif //INC_IMU_H_ 
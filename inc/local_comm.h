@@ -36,30 +36,61 @@
 //****************************************************************************
 
 #include <stdint.h>
+#include "flexsea_comm_multi.h"
+#include "flexsea_cmd_stream.h"
+#include "flexsea_sys_def.h"
 
-//***************************************************************************
-// Shared variable(s)
+//****************************************************************************
+// Definition(s):
 //****************************************************************************
 
+//Multi-packet commands (read): CMD_STREAM_BUNDLE (reply: n x [cmd, len,
+//payload]) & CMD_STREAM_STATS. Their codes are allocated in flexsea_sys_def.h
+//(flexsea-system), like all the others:
+#if !defined(CMD_STREAM_BUNDLE) || !defined(CMD_STREAM_STATS)
+#error "CMD_STREAM_BUNDLE/CMD_STREAM_STATS missing: update flexsea-system"
+#endif
 
+//Bytes of stream payloads per bundle. The first payload always goes (up to 255
+//bytes), the multi-packet buffer needs room for that.
+#define STREAM_BUNDLE_MAX_LEN	192
+#define STREAM_NONE				0xFF
+
+#define STREAM_STATS_WINDOW		1000	//autoStream() calls (1s)
 
 //****************************************************************************
-// Public Function Prototype(s):
+// Structure(s)
 //****************************************************************************
 
-void initLocalComm(void);
-void parseMasterCommands(uint8_t *new_cmd);
-void autoStream(void);
-void sendMasterDelayedResponse(void);
+//One per active stream (streamCmds[] index). Rates in Hz, over the last
+//STREAM_STATS_WINDOW.
+struct stream_stats_s
+{
+	uint16_t requestedHz;
+	uint16_t achievedHz;
+	uint16_t deferred;			//Due, but postponed to a later slot
+	uint16_t maxLate;			//ms after the deadline
+	uint16_t sent, deferredCnt, maxLateCnt;		//Current window
+	uint16_t len;				//Last payload, bytes
+};
 
 //****************************************************************************
-// Definition(s):
+// Shared variable(s)
 //****************************************************************************
 
+extern struct stream_stats_s streamStats[MAX_STREAMS];
 
 //****************************************************************************
-// Structure(s)
+// Public Function Prototype(s):
 //****************************************************************************
 
+void initLocalComm(void);
+void parseMasterCommands(uint8_t *new_cmd);
+void autoStream(void);
+void sendMasterDelayedResponse(void);
+void rx_multi_cmd_stream_bundle_rr(uint8_t *msgBuf, MultiPacketInfo *info, \
+									uint8_t *responseBuf, uint16_t* responseLen);
+void rx_multi_cmd_stream_stats_rr(uint8_t *msgBuf, MultiPacketInfo *info, \
+									uint8_t *responseBuf, uint16_t* responseLen);
 
 #endif	//INC_LOCAL_COMM_H
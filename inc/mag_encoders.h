@@ -45,11 +45,12 @@
 
 void init_as5047(void);
 uint16 as5047_read_single_isr(uint16 reg);
-void init_angle_timer(void);
+int32_t pwm_lead_us(uint32_t stamp);
 
 int as5048b_read(uint8_t internal_reg_addr, uint8_t *pData, uint16 length);
 void as5048b_test_code_blocking(void);
 void get_as5048b_position(void);
+void as5048b_decode(uint8_t *buf);
 
 void update_counts_since_last_ang_read(struct as504x_s *as504x);
 void reset_ang_counter(struct as504x_s *);
@@ -59,7 +60,9 @@ void init_as504x(struct as504x_s *as504x);
 void update_as504x(int32_t ang, struct as504x_s *as504x);
 void update_as504x_absang(int32_t ang, struct as504x_s *as504x);
 void update_as504x_contang(struct as504x_s *as504x);
-void update_as504x_vel(struct as504x_s *as504x);
+void init_as5047_vel(void);
+void update_as5047_vel(void);
+void update_as5047_vel_pll(int32_t ang);
 
 //****************************************************************************
 // Shared Variable(s):
@@ -72,6 +75,7 @@ extern uint16 spidata_mosi2[];
 extern uint16 as5047_angle;
 extern volatile int32_t spi_read_flag;
 extern volatile uint16 as5047_empty_read;
+extern struct vel_pll_s velPll;
 
 //****************************************************************************
 // Definition(s):
@@ -98,6 +102,25 @@ extern volatile uint16 as5047_empty_read;
 
 #define SPI_TX_MAX_INDEX		1
 
+//Velocity compensated angle (ang_comp_clks): extrapolated from its timestamp to
+//the middle of the first PWM period that uses the new duty cycles (they are
+//latched at the next reload)
+#define PWM_LEAD_US				(PWM_PERIOD_US + PWM_PERIOD_US / 2)
+
+//Velocity estimator (filt_vel_cpms & signed_ang_vel):
+#define VEL_EST_DIFF			0	//Differences at 1kHz (update_as5047_vel())
+#define VEL_EST_PLL				1	//Tracking loop, every encoder read
+#ifndef VEL_ESTIMATOR
+#define VEL_ESTIMATOR			VEL_EST_PLL
+#endif
+
+//PLL: angle in Q18 counts (2^32 = 1 turn), velocity in Q18 counts/read.
+//Gains are shifts: wn*T = 1/16 (~200Hz at 20kHz), critically damped.
+#define VEL_PLL_READS_PER_MS	20			//isr_mot, 20kHz
+#define VEL_PLL_ANG_SHIFT		18			//14-bit encoder
+#define VEL_PLL_KP_SHIFT		3			//2*zeta*wn*T
+#define VEL_PLL_KI_SHIFT		8			//(wn*T)^2
+
 //AS5048B Magnetic Encoder (I2C):
 
 #define I2C_ADDR_AS5048B		0b1000000	//A1 & A2 forced low, default address
@@ -108,4 +131,16 @@ extern volatile uint16 as5047_empty_read;
 #define AD5048B_REG_ANGLE_H		254
 #define AD5048B_REG_ANGLE_L		255
 
+//****************************************************************************
+// Structure(s)
+//****************************************************************************
+
+struct vel_pll_s
+{
+	uint32_t ang;			//Q18 counts, wraps with the encoder
+	int32_t vel;			//Q18 counts per read
+	int32_t err;			//Last angle error, Q18 counts
+	uint8_t init;
+};
+
 #endif	//INC_MAG_ENCODERS_H
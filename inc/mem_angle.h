@@ -69,6 +69,9 @@ FLASH so the value of this code is very limited...
 //Joint:
 #define EE_ANGLE_JOINT_START		20
 #define EE_ANGLE_JOINT_LEN			40
+//Motor parameters (motor_id):
+#define EE_MOTOR_ID_START			60
+#define EE_MOTOR_ID_LEN				2
 
 //#define EE_SIZE_BYTES				(EE_ROW_LEN_BYTES * EE_ANGLE_MAX_ROW)
 
@@ -83,7 +86,8 @@ FLASH so the value of this code is very limited...
 
 typedef enum{
 	COMMUTATION = 0, 
-	JOINT} eepromTable; 
+	JOINT,
+	MOTOR_ID} eepromTable; 
 
 //****************************************************************************
 // Public Function Prototype(s):
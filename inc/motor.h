@@ -40,6 +40,8 @@
 //****************************************************************************
 // Shared variable(s)
 //****************************************************************************
+
+extern uint16_t myPWMcompareA, myPWMcompareB, myPWMcompareC;
 	
 //****************************************************************************
 // Prototype(s):
@@ -63,6 +65,10 @@ void setDmaPwmCompare(uint16_t a, uint16_t b, uint16_t c);
 // Definition(s):
 //****************************************************************************
 
+//PWM A, B & C frequency (set in the schematic). isr_mot runs at this rate.
+#define PWM_FREQ_HZ					20000
+#define PWM_PERIOD_US				(1000000 / PWM_FREQ_HZ)
+
 //PWM limits
 #define MAX_PWM						1000
 #define MIN_PWM						(-MAX_PWM)
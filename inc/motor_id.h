@@ -0,0 +1,156 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-execute' Advanced Motion Controller
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] motor_id: motor parameter identification (R, L, Ke, inertia)
+	& current loop feed-forward terms
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-17 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_MOTOR_ID_H
+#define INC_MOTOR_ID_H
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include "main.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+//Electrical tests (SPI ISR, rotor locked by the current): DC on phase A, B & C
+//at PWM_AMP. The duty is raised until MOTOR_ID_ALIGN_MA flows.
+#define MOTOR_ID_REST_MS			1500		//PWM off, current zeroes
+#define MOTOR_ID_ALIGN_MA			2000
+#define MOTOR_ID_ALIGN_STEP_MS		10			//+1 PWM count per step
+#define MOTOR_ID_DUTY_MAX			150			//Aborts if not enough current
+#define MOTOR_ID_ALIGN_MS			500			//Rotor settling
+#define MOTOR_ID_R_SETTLE_MS		50
+#define MOTOR_ID_R_AVG_MS			100
+#define MOTOR_ID_STEP_SAMPLES		64			//Current after the step, 1/PWM period
+#define MOTOR_ID_STEP_FIRST			2			//First sample used for L
+#define MOTOR_ID_L_MIN_MA			50			//L is kept if the step is flatter
+#define MOTOR_ID_MA_PER_LSB			16			//Same as FOC_MA_PER_LSB
+#define MOTOR_ID_LOCKED_CPMS		2			//Aborts if the rotor moves (load?)
+
+//Mechanical tests (1kHz, sine commutation, rotor free): two voltages
+#define MOTOR_ID_SPIN_MV_1			3000		//setMotorVoltage() units
+#define MOTOR_ID_SPIN_MV_2			6000
+#define MOTOR_ID_SPIN_SETTLE_MS		1500
+#define MOTOR_ID_SPIN_AVG_MS		500
+#define MOTOR_ID_J_MS				200			//Acceleration, 1 to 2
+#define MOTOR_ID_MIN_CPMS			5			//Aborts if slower (or locked)
+
+//Whole procedure, aborts if longer (normal: ~8s)
+#define MOTOR_ID_TIMEOUT_MS			15000
+
+//setMotorVoltage() mV to phase peak mV (sine, 1024 = PWM_AMP = Vb/2):
+#define MOTOR_ID_CMD_NUM			((int64_t)577 * PWM_AMP)
+#define MOTOR_ID_CMD_DEN			((int64_t)1024 * PWM_MAX)
+//counts/ms to mrad/s, x1000:
+#define MOTOR_ID_CPMS_MRADS_K		383495
+
+//Feed-forward. current.actual_val is 3/2 x the phase peak current (mA).
+//R & back-EMF: setMotorVoltage() mV per mA & per count/ms, Q10.
+//L: calc_motor_L() gain, 149 x (pole pairs) x 2pi/16.384 x 2/3 x 2048 x 1e-6
+//per uH.
+#define MOTOR_ID_FF_SHIFT			10
+#define MOTOR_ID_R_FF(mohm)			((int32_t)(((int64_t)(mohm) * 2048 * MOTOR_ID_CMD_DEN) / (3000 * MOTOR_ID_CMD_NUM)))
+#define MOTOR_ID_BEMF_FF(ke)		((int32_t)(((int64_t)(ke) * 3927 * MOTOR_ID_CMD_DEN) / (10000 * MOTOR_ID_CMD_NUM)))
+#define MOTOR_ID_L_FF(uh)			(((int32_t)(uh) * (NUMPOLES / 6) * 78) / 1000)
+
+//Back-EMF compensation, %. The speed is filtered (late): all of it removes
+//the back-EMF damping and the current loop can run away (sim: above ~90%).
+#define MOTOR_ID_BEMF_FF_PCT		75
+
+//Until identified (hand-tuned values):
+#define MOTOR_ID_R_FF_DEFAULT		((1 << MOTOR_ID_FF_SHIFT) / 10)
+#define MOTOR_ID_BEMF_FF_DEFAULT	(37 << MOTOR_ID_FF_SHIFT)
+#define MOTOR_ID_L_FF_DEFAULT		70
+
+//Storage (USE_EEPROM): EEPROM table MOTOR_ID, the results (int32, MSW first)
+//then the magic word
+#define MOTOR_ID_EE_WORDS			(EE_MOTOR_ID_LEN * EE_ROW_LEN_WORD)
+#define MOTOR_ID_PARAMS				4
+#define MOTOR_ID_PARAM_PTRS			{&motorId.r, &motorId.l, &motorId.ke, &motorId.j}
+#define MOTOR_ID_MAGIC				0x1D1E		//0x1D1D: 6 parameters (friction)
+
+//motorId.state:
+#define MOTOR_ID_IDLE				0
+#define MOTOR_ID_WAIT				1
+#define MOTOR_ID_ALIGN				2
+#define MOTOR_ID_R_HI				3
+#define MOTOR_ID_R_LO				4
+#define MOTOR_ID_STEP				5
+#define MOTOR_ID_SPIN_1				6
+#define MOTOR_ID_SPIN_2				7
+#define MOTOR_ID_DONE				8
+
+//****************************************************************************
+// Structure(s)
+//****************************************************************************
+
+struct motor_id_s
+{
+	//Results, phase values (star):
+	int32_t r;							//mOhm
+	int32_t l;							//uH
+	int32_t ke;							//uV/(rad/s), peak. Also uNm per actual_val mA
+	int32_t j;							//g.mm^2 (1e-9 kg.m^2)
+	uint8_t valid;						//Identified or loaded from EEPROM. The
+										//feed-forward is only updated then.
+	uint8_t state;
+	uint8_t aborted;					//State of the last failed test
+
+	//Used by the current loops:
+	int32_t rFF, bemfFF, lFF;
+
+	//SPI ISR (motor_id_isr()):
+	volatile uint8_t hold;				//Drives phase A instead of the commutation
+	volatile int16_t duty;				//Phase A, PWM counts above PWM_AMP
+	volatile uint8_t acc;				//Accumulates the phase A current
+	volatile int32_t iSum;
+	volatile uint16_t iCnt;
+	volatile uint16_t stepIdx;
+	int16_t step[MOTOR_ID_STEP_SAMPLES];	//Phase A, mA
+};
+
+//****************************************************************************
+// Shared variable(s)
+//****************************************************************************
+
+extern struct motor_id_s motorId;
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+void init_motor_id(void);
+uint8_t motor_id_calibration(void);
+void motor_id_isr(void);
+
+#endif	//INC_MOTOR_ID_H
@@ -0,0 +1,75 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-execute' Advanced Motion Controller
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] ringbuf: ring buffers with O(1) windowed mean & slope
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-17 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_RINGBUF_H
+#define INC_RINGBUF_H
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include "main.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+#define RINGBUF_LEN			64		//Power of 2, max window
+#define RINGBUF_MASK		(RINGBUF_LEN - 1)
+
+//****************************************************************************
+// Structure(s)
+//****************************************************************************
+
+//The sums are modulo 2^32 (uint32): the slope only depends on differences
+//and stays exact with large values (unwrapped angles). The mean needs the
+//real sum to fit in an int32.
+struct ringbuf_s
+{
+	int32_t buf[RINGBUF_LEN];
+	uint32_t sum;				//Last 'window' samples
+	uint32_t ageSum;			//Sum of age * sample, newest = age 0
+	int32_t slopeDen;			//N(N^2-1)/6
+	uint8_t idx;				//Newest sample
+	uint8_t window;
+};
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+void ringbuf_init(struct ringbuf_s *rb, uint8_t window);
+void ringbuf_push(struct ringbuf_s *rb, int32_t x);
+int32_t ringbuf_get(struct ringbuf_s *rb, uint8_t age);
+int32_t ringbuf_diff(struct ringbuf_s *rb, uint8_t lag);
+int32_t ringbuf_mean(struct ringbuf_s *rb);
+int32_t ringbuf_slope(struct ringbuf_s *rb, int32_t scale);
+
+#endif	//INC_RINGBUF_H
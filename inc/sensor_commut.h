@@ -36,6 +36,7 @@
 //****************************************************************************
 
 #include "main.h"
+#include "fixed_math.h"
 
 //****************************************************************************
 // Shared variable(s)
@@ -46,9 +47,8 @@ extern int findingpoles;
 extern uint8_t measure_motor_resistance;
 extern volatile uint8_t badFindPoles;
 
-extern int16 phaseAcoms[2048];
-extern int16 phaseBcoms[2048];
-extern int16 phaseCcoms[2048];
+extern uint16 commElecAng[2048];
+extern volatile uint8_t pwmModulation;
 
 extern int32_t PWM_A_Value;
 extern int32_t PWM_B_Value;
@@ -60,11 +60,13 @@ extern int32_t PWM_C_Value;
 
 void find_poles(void);
 void load_eeprom_to_angles(void);
-void fill_comm_tables(int32,int16_t *);
+uint16 get_comm_elec_angle(int32);
 void sensor_sin_commut(int16, int32);
+void comm_duty_cycles(uint16 e, int32 pwm, int32 ind, int32 *duty);
+void pwm_modulate(int32 *v, int32 m2);
 
 void test_sinusoidal_blocking(void);
-int get_sin_profile(double, double);
+void modulation_test(void);
 
 void calc_motor_L(void);
 
@@ -77,10 +79,39 @@ void calc_motor_L(void);
 #define PWM_AMP         495//(2000-PWM_DEAD)/4
 #define MAX_ENC         16383
 //#define PWM_DEAD2		41 //dead time caused by the opening and closing of the FETS
+
+//Commutation values from an electrical angle (commElecAng[]):
+#define COMM_PHASE_B	21845	//120deg
+#define COMM_PHASE_C	43691	//240deg
+#define COMM_SIN(e)		((PWM_AMP * (int32)sin_q15((uint16)(e)) + (1 << 14)) >> 15)	//+/-PWM_AMP
+#define COMM_COS(e)		((1024 * (int32)cos_q15((uint16)(e)) + (1 << 14)) >> 15)	//+/-1024
+
+//Modulation (pwmModulation). SVPWM & THI only change the common mode, they
+//give ~15% more line-to-line voltage before clipping.
+#define MOD_SINE		0
+#define MOD_SVPWM		1
+#define MOD_THI			2		//Third harmonic injection, 1/6
+#define THI_DIV_1536	43691	//2^26 / 1536, x/1536 = (x * THI_DIV_1536) >> 26
+#ifndef PWM_MODULATION
+#define PWM_MODULATION	MOD_SINE
+#endif
+
+//modulation_test():
+#define MOD_TEST_POINTS	1024
+#define MOD_TEST_AMP	1182	//2/sqrt(3) x 1024, SVPWM & THI limit
 //****************************************************************************
 
 //****************************************************************************
 // Structure(s)
 //****************************************************************************
 
+struct mod_test_s
+{
+	int32 maxAmp;		//Largest amplitude without clipping (1024 = PWM_AMP)
+	int32 vllPerMil;	//Peak line-to-line voltage at maxAmp / bus voltage
+	int32 thdPerMil;	//Line-to-line THD at MOD_TEST_AMP
+};
+
+extern volatile struct mod_test_s modTest[3];
+
 #endif	//INC_SENSOR_COMMUT_H
@@ -48,24 +48,68 @@ void rs485_putc(uint8_t byte);
 void rs485_puts(uint8_t *buf, uint32 len);
 void bt_puts(uint8_t *buf, uint32 len);
 void rs485DelayedTransmit(PacketWrapper* p);
+void rs485_reply_service(void);
+void rs485_rx_poll(void);
+void rs485_rx_dma_isr(void);
+void rs485_tx_dma_isr(void);
+void rs485_t2_isr(void);
 void test_uart_dma_xmit(void);
+void rs485_tx_benchmark(void);
 
 //****************************************************************************
-// Shared Variable(s):
+// Definition(s):
 //****************************************************************************
 
-extern uint8_t uart_dma_rx_buf[96];
-extern uint8_t uart_dma_tx_buf[96];
-extern uint8_t uart_dma_rx_buf_unwrapped[96];
-extern uint8_t uart_dma_bt_rx_buf[96];
-extern uint8_t uart_dma_bt_rx_buf_unwrapped[96];
+//Replies to our master: minimum turnaround (rs485ReplyDelayUs), queue
+#define RS485_REPLY_DELAY_US	100
+#define RS485_REPLY_QUEUE_LEN	4		//Power of 2
+#define RS485_REPLY_QUEUE_MASK	(RS485_REPLY_QUEUE_LEN - 1)
 
-extern uint8_t DMA_3_Chan;
+#define UART_DMA_BUF_LEN		96
+
+//RS-485 RX: the DMA loops on a 48 bytes TD (interrupt when it wraps). Bytes
+//are also handed to the parser when the line is idle for RS485_RX_IDLE_TICKS
+//calls of rs485_rx_poll() (10kHz).
+#define RS485_RX_TD_LEN			48
+#define RS485_RX_IDLE_TICKS		1
+
+//RS-485 transmission, sequenced by Timer_2 (one-shot) & the TX DMA:
+#define RS485_TX_IDLE			0
+#define RS485_TX_SETUP			1		//Transceiver switched, not sending yet
+#define RS485_TX_SENDING		2		//DMA
+#define RS485_TX_TURNAROUND		3		//Last bytes leaving the UART
+#define RS485_SETUP_US			3
+#define RS485_BENCH_N			256
+
+//RS-485 TX TD, the length is set by rs485_puts():
+#define RS485_TX_TD_CONFIG		(TD_TERMIN_EN | DMA_4__TD_TERMOUT_EN | TD_INC_SRC_ADR | TD_AUTO_EXEC_NEXT)
 
 //****************************************************************************
-// Definition(s):
+// Structure(s)
 //****************************************************************************
 
-#define REPLY_DELAY		3	//How many FSM states do we wait for?
+//Queued reply, sent once fsmTimingNowUs() reaches dueUs
+struct rs485_reply_s
+{
+	uint8_t buf[UART_DMA_BUF_LEN];
+	uint8_t len;
+	uint32_t dueUs;
+};
+
+//****************************************************************************
+// Shared Variable(s):
+//****************************************************************************
+
+extern uint8_t uart_dma_rx_buf[UART_DMA_BUF_LEN];
+extern uint8_t uart_dma_tx_buf[UART_DMA_BUF_LEN];
+extern uint8_t uart_dma_rx_buf_unwrapped[UART_DMA_BUF_LEN];
+extern uint8_t uart_dma_bt_rx_buf[UART_DMA_BUF_LEN];
+extern uint8_t uart_dma_bt_rx_buf_unwrapped[UART_DMA_BUF_LEN];
+
+extern uint8_t DMA_3_Chan;
+extern volatile uint8_t rs485TxState;
+extern uint32_t rs485BenchCycles, rs485BenchLegacyCycles;
+extern uint32_t rs485ReplyDelayUs;
+extern uint16_t rs485ReplyDropped;
 
 #endif	//INC_SERIAL_H
@@ -67,6 +67,7 @@ int strain_6ch_read(uint8_t internal_reg_addr, uint8_t *pData, uint16 length);
 void strain_amp_6ch_test_code_blocking(void);
 void strain_6ch_bytes_to_words(uint8_t *buf);
 void get_6ch_strain(void);
+void strain_6ch_decode(uint8_t *buf);
 uint8_t compressAndSplit6ch(uint8_t *buf, uint16 ch0, uint16 ch1, uint16 ch2, \
 							uint16 ch3, uint16 ch4, uint16 ch5);
 void unpackCompressed6ch(uint8_t *buf, uint16 *v0, uint16 *v1, uint16 *v2, \
@@ -48,7 +48,7 @@ extern uint8_t minm_rgb_color;
 //****************************************************************************
 
 void i2c_init_minm(uint8_t color);
-void i2c_write_minm_rgb(uint8_t cmd, uint8_t r, uint8_t g, uint8_t b);
+uint8_t i2c_write_minm_rgb(uint8_t cmd, uint8_t r, uint8_t g, uint8_t b);
 void minm_byte_to_rgb(uint8_t byte, uint8_t *r, uint8_t *g, uint8_t *b);
 uint8_t update_minm_rgb(void);
 void minm_test_code(void);
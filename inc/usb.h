@@ -48,6 +48,7 @@
 uint8_t init_usb(void);
 void get_usb_data(void);
 uint8_t usb_puts(uint8_t *buf, uint32 len);
+void usb_tx_service(void);
 void usbRuntimeConnect(void);
 
 //****************************************************************************
@@ -56,6 +57,31 @@ void usbRuntimeConnect(void);
 
 #define USB_ENUM_TIMEOUT			2500	//ms
 #define BUFFER_LEN					64
+
+//TX queue. Frames are copied: the packer buffers are reused at the next reply,
+//before a queued frame is sent.
+#define USB_TX_QUEUE_LEN			512		//Bytes, power of 2
+#define USB_TX_QUEUE_MASK			(USB_TX_QUEUE_LEN - 1)
+#define USB_TX_PACKET_LEN			64		//Full speed bulk endpoint
+
+//****************************************************************************
+// Structure(s)
+//****************************************************************************
+
+struct usb_tx_s
+{
+	uint8_t buf[USB_TX_QUEUE_LEN];
+	uint16_t head, tail;
+	uint8_t zlp;							//Last packet was full & nothing follows
+	uint32_t packets, bytes, dropped;
+	uint32_t flushed;						//Bytes discarded, host gone
+};
+
+//****************************************************************************
+// Shared variable(s)
+//****************************************************************************
+
+extern struct usb_tx_s usbTx;
 	
 #endif	//USE_USB
 
@@ -0,0 +1,421 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-execute' Advanced Motion Controller
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] project: host simulation stand-in for the PSoC Creator
+	generated project.h. Only the parts of the component APIs used by
+	/src are declared. Implementation in sim_hal.c.
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-17 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef SIM_PROJECT_H
+#define SIM_PROJECT_H
+
+#ifndef SIM_HOST
+#error "sim/project.h is only used by the host simulation build (SIM_HOST)"
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <stdint.h>
+#include <stddef.h>
+
+//****************************************************************************
+// cytypes.h / cydevice.h / CyLib.h:
+//****************************************************************************
+
+typedef uint8_t		uint8;
+typedef uint16_t	uint16;
+typedef uint32_t	uint32;
+typedef int8_t		int8;
+typedef int16_t		int16;
+typedef int32_t		int32;
+typedef int64_t		int64;
+typedef uint64_t	uint64;
+typedef volatile uint8_t	reg8;
+typedef volatile uint16_t	reg16;
+typedef volatile uint32_t	reg32;
+typedef uint32_t	cystatus;
+
+#define CYRET_SUCCESS				((cystatus)0x00u)
+#define CYRET_UNKNOWN				((cystatus)0x01u)
+#define CYRET_BAD_PARAM				((cystatus)0x02u)
+#define CYRET_TIMEOUT				((cystatus)0x10u)
+
+#define CY_ISR(FuncName)			void FuncName (void)
+#define CY_ISR_PROTO(FuncName)		void FuncName (void)
+
+#ifndef __STATIC_INLINE
+#define __STATIC_INLINE				static inline
+#endif
+
+#define LO16(x)						((uint16)(((uintptr_t)(x)) & 0xFFFFu))
+#define HI16(x)						((uint16)((((uintptr_t)(x)) >> 16) & 0xFFFFu))
+
+#define CYDEV_PERIPH_BASE			0x40000000u
+#define CYDEV_SRAM_BASE				0x1FFF8000u
+
+//CPU/bus clock (cyfitter.h)
+#define BCLK__BUS_CLK__HZ			80000000u
+
+//Register accesses go through the HAL so it can react to them (SPI TX, etc.)
+#define CY_SET_REG8(addr, value)	simHalRegWrite((volatile void *)(addr), (uint32)(value), 1)
+#define CY_SET_REG16(addr, value)	simHalRegWrite((volatile void *)(addr), (uint32)(value), 2)
+#define CY_SET_REG32(addr, value)	simHalRegWrite((volatile void *)(addr), (uint32)(value), 4)
+#define CY_GET_REG8(addr)			(*(reg8 *)(addr))
+#define CY_GET_REG16(addr)			(*(reg16 *)(addr))
+#define CY_GET_REG32(addr)			(*(reg32 *)(addr))
+
+#define CyGlobalIntEnable			do{simHalIntEnable(1);}while(0)
+#define CyGlobalIntDisable			do{simHalIntEnable(0);}while(0)
+
+void simHalRegWrite(volatile void *addr, uint32 value, uint8 size);
+void simHalIntEnable(uint8 en);
+
+void CyDelay(uint32 milliseconds);
+void CyDelayUs(uint16 microseconds);
+uint8 CyEnterCriticalSection(void);
+void CyExitCriticalSection(uint8 savedIntrStatus);
+
+//DMA (CyDmac.h):
+#define CY_DMA_DISABLE_TD			0xFEu
+#define TD_TERMIN_EN				0x80u
+#define TD_TERMOUT1_EN				0x40u
+#define TD_TERMOUT0_EN				0x20u
+#define TD_AUTO_EXEC_NEXT			0x10u
+#define TD_INC_DST_ADR				0x08u
+#define TD_INC_SRC_ADR				0x04u
+#define TD_SWAP_SIZE4				0x02u
+#define TD_SWAP_EN					0x01u
+
+uint8 CyDmaTdAllocate(void);
+cystatus CyDmaTdSetConfiguration(uint8 tdHandle, uint16 transferCount, uint8 nextTd, uint8 configuration);
+cystatus CyDmaTdGetConfiguration(uint8 tdHandle, uint16 *transferCount, uint8 *nextTd, uint8 *configuration);
+cystatus CyDmaTdSetAddress(uint8 tdHandle, uint16 source, uint16 destination);
+cystatus CyDmaChSetInitialTd(uint8 chHandle, uint8 startTd);
+cystatus CyDmaChEnable(uint8 chHandle, uint8 preserveTds);
+cystatus CyDmaChDisable(uint8 chHandle);
+cystatus CyDmaClearPendingDrq(uint8 chHandle);
+
+//Every DMA component shares the same prototype:
+#define SIM_DMA_COMPONENT(name)																\
+	uint8 name##_DmaInitialize(uint8 burstCount, uint8 requestPerBurst,					\
+								uint16 upperSrcAddress, uint16 upperDestAddress);
+#define SIM_DMA_TERMOUT_EN			TD_TERMOUT0_EN
+
+SIM_DMA_COMPONENT(DMA_1)
+SIM_DMA_COMPONENT(DMA_2)
+SIM_DMA_COMPONENT(DMA_3)
+SIM_DMA_COMPONENT(DMA_4)
+SIM_DMA_COMPONENT(DMA_5)
+SIM_DMA_COMPONENT(DMA_6)
+SIM_DMA_COMPONENT(DMA_PA)
+SIM_DMA_COMPONENT(DMA_PB)
+SIM_DMA_COMPONENT(DMA_PC)
+
+#define DMA_1__TD_TERMOUT_EN		SIM_DMA_TERMOUT_EN
+#define DMA_2__TD_TERMOUT_EN		SIM_DMA_TERMOUT_EN
+#define DMA_3__TD_TERMOUT_EN		SIM_DMA_TERMOUT_EN
+#define DMA_4__TD_TERMOUT_EN		SIM_DMA_TERMOUT_EN
+#define DMA_5__TD_TERMOUT_EN		SIM_DMA_TERMOUT_EN
+#define DMA_6__TD_TERMOUT_EN		SIM_DMA_TERMOUT_EN
+#define DMA_PA__TD_TERMOUT_EN		SIM_DMA_TERMOUT_EN
+#define DMA_PB__TD_TERMOUT_EN		SIM_DMA_TERMOUT_EN
+#define DMA_PC__TD_TERMOUT_EN		SIM_DMA_TERMOUT_EN
+
+//****************************************************************************
+// Interrupt components:
+//****************************************************************************
+
+#define SIM_ISR_COMPONENT(name)																\
+	void name##_Start(void);																\
+	void name##_Stop(void);																	\
+	void name##_ClearPending(void);
+
+SIM_ISR_COMPONENT(isr_t1)
+SIM_ISR_COMPONENT(isr_t2)
+SIM_ISR_COMPONENT(isr_sar1_dma)
+SIM_ISR_COMPONENT(isr_sar2_dma)
+SIM_ISR_COMPONENT(isr_dma_uart_rx)
+SIM_ISR_COMPONENT(isr_dma_uart_tx)
+SIM_ISR_COMPONENT(isr_dma_uart_bt_rx)
+SIM_ISR_COMPONENT(isr_delsig)
+SIM_ISR_COMPONENT(isr_spi_tx)
+SIM_ISR_COMPONENT(isr_mot)
+
+//****************************************************************************
+// Digital components:
+//****************************************************************************
+
+//Pins and control/status registers:
+#define SIM_PIN_W(name)		void name##_Write(uint8 value);
+#define SIM_PIN_R(name)		uint8 name##_Read(void);
+
+SIM_PIN_W(LED_R)
+SIM_PIN_W(LED_G)
+SIM_PIN_W(LED_B)
+SIM_PIN_W(LED_HB)
+SIM_PIN_W(WDCLK)
+SIM_PIN_W(DE)
+SIM_PIN_W(NOT_RE)
+SIM_PIN_W(UART_DMA_XMIT)
+SIM_PIN_W(T2_RESET)
+SIM_PIN_W(EX2)
+SIM_PIN_W(EX15)
+SIM_PIN_W(Coast_Brake)
+SIM_PIN_W(Control_Reg_1)
+SIM_PIN_W(PWM_Kill)
+SIM_PIN_W(Use_Hall)
+SIM_PIN_W(Virtual_Hall)
+SIM_PIN_W(MotorDirection)
+SIM_PIN_R(MotorDirection)
+SIM_PIN_R(EX1)
+SIM_PIN_R(EX2)
+SIM_PIN_R(EX3)
+SIM_PIN_R(Status_Reg_1)
+
+extern reg8 MotorDirection_Control;
+
+//Timers (down counters):
+void Timer_1_Init(void);
+void Timer_1_Start(void);
+void Timer_1_Stop(void);
+void Timer_1_WritePeriod(uint16 period);
+uint16 Timer_1_ReadPeriod(void);
+uint16 Timer_1_ReadCounter(void);
+uint8 Timer_1_ReadStatusRegister(void);
+void Timer_2_Init(void);
+void Timer_2_Start(void);
+void Timer_2_Stop(void);
+void Timer_2_WritePeriod(uint16 period);
+uint16 Timer_2_ReadPeriod(void);
+uint8 Timer_2_ReadStatusRegister(void);
+
+//PWM:
+void PWM_A_Start(void);
+void PWM_A_WriteCompare(uint16 compare);
+void PWM_B_Start(void);
+void PWM_B_WriteCompare(uint16 compare);
+void PWM_C_Start(void);
+void PWM_C_WriteCompare(uint16 compare);
+void PWM_1_Start(void);
+void PWM_1_WriteCompare1(uint16 compare);
+void PWM_1_WriteCompare2(uint16 compare);
+uint16 PWM_1_ReadCompare1(void);
+void PWM_4_Start(void);
+void PWM_4_WriteCompare(uint8 compare);
+
+extern reg16 simPwmCompareReg[4];
+#define PWM_A_COMPARE1_LSB_PTR		(&simPwmCompareReg[0])
+#define PWM_B_COMPARE1_LSB_PTR		(&simPwmCompareReg[1])
+#define PWM_C_COMPARE1_LSB_PTR		(&simPwmCompareReg[2])
+#define PWM_1_COMPARE1_LSB_PTR		(&simPwmCompareReg[3])
+#define PWM_1_COMPARE2_LSB_PTR		(&simPwmCompareReg[3])
+
+//Quadrature decoder:
+void QuadDec_1_Start(void);
+void QuadDec_1_Enable(void);
+void QuadDec_1_SetCounter(int32 value);
+int32 QuadDec_1_GetCounter(void);
+
+//Clock:
+void C8M_SetDividerValue(uint16 clkDivider);
+
+//SPI Master (AS5047):
+#define SPIM_1_INT_ON_SPI_DONE		0x01u
+#define SPIM_1_INT_ON_TX_EMPTY		0x02u
+#define SPIM_1_INT_ON_TX_NOT_FULL	0x04u
+#define SPIM_1_INT_ON_BYTE_COMP		0x08u
+#define SPIM_1_STS_SPI_DONE			0x01u
+#define SPIM_1_STS_BYTE_COMPLETE	0x08u
+
+void SPIM_1_Start(void);
+void SPIM_1_SetTxInterruptMode(uint8 intSrc);
+void SPIM_1_WriteTxData(uint16 txData);
+uint16 SPIM_1_ReadRxData(void);
+uint8 SPIM_1_ReadTxStatus(void);
+void SPIM_1_ClearFIFO(void);
+
+extern reg16 simSpimTxDataReg;
+#define SPIM_1_TXDATA_PTR			(&simSpimTxDataReg)
+
+//UARTs:
+void UART_1_Init(void);
+void UART_1_Enable(void);
+void UART_1_Start(void);
+void UART_1_PutArray(const uint8 string[], uint8 byteCount);
+void UART_2_Init(void);
+void UART_2_Enable(void);
+void UART_2_Start(void);
+void UART_2_ClearTxBuffer(void);
+void UART_2_PutChar(uint8 txDataByte);
+
+extern reg8 simUartDataReg[4];
+#define UART_1_RXDATA_PTR			(&simUartDataReg[0])
+#define UART_1_TXDATA_PTR			(&simUartDataReg[1])
+#define UART_2_RXDATA_PTR			(&simUartDataReg[2])
+#define UART_2_TXDATA_PTR			(&simUartDataReg[3])
+
+//USB CDC:
+#define USBUART_1_5V_OPERATION		0x01u
+#define USBUART_1_3V_OPERATION		0x00u
+
+void USBUART_1_Start(uint8 device, uint8 mode);
+uint8 USBUART_1_GetConfiguration(void);
+void USBUART_1_CDC_Init(void);
+uint8 USBUART_1_DataIsReady(void);
+uint16 USBUART_1_GetAll(uint8 *pData);
+uint8 USBUART_1_CDCIsReady(void);
+void USBUART_1_PutData(const uint8 *pData, uint16 length);
+
+//****************************************************************************
+// I2C masters:
+//****************************************************************************
+
+#define I2C_0_MODE_COMPLETE_XFER	0x00u
+#define I2C_0_MODE_REPEAT_START		0x01u
+#define I2C_0_MODE_NO_STOP			0x02u
+#define I2C_0_MSTR_NO_ERROR			0x00u
+#define I2C_0_MSTR_BUS_BUSY			0x01u
+#define I2C_0_MSTR_NOT_READY		0x02u
+#define I2C_0_MSTR_ERR_LB_NAK		0x03u
+#define I2C_0_MSTAT_RD_CMPLT		0x01u
+#define I2C_0_MSTAT_WR_CMPLT		0x02u
+#define I2C_0_MSTAT_XFER_INP		0x04u
+#define I2C_0_MSTAT_ERR_XFER		0x80u
+#define I2C_0_SM_MSTR_HALT			0x60u
+#define I2C_0_SM_MSTR_WR_DATA		0x42u
+
+#define I2C_1_MODE_COMPLETE_XFER	I2C_0_MODE_COMPLETE_XFER
+#define I2C_1_MODE_REPEAT_START		I2C_0_MODE_REPEAT_START
+#define I2C_1_MODE_NO_STOP			I2C_0_MODE_NO_STOP
+#define I2C_1_MSTR_NO_ERROR			I2C_0_MSTR_NO_ERROR
+#define I2C_1_MSTR_BUS_BUSY			I2C_0_MSTR_BUS_BUSY
+#define I2C_1_MSTR_NOT_READY		I2C_0_MSTR_NOT_READY
+#define I2C_1_MSTR_ERR_LB_NAK		I2C_0_MSTR_ERR_LB_NAK
+#define I2C_1_MSTAT_RD_CMPLT		I2C_0_MSTAT_RD_CMPLT
+#define I2C_1_MSTAT_WR_CMPLT		I2C_0_MSTAT_WR_CMPLT
+#define I2C_1_MSTAT_XFER_INP		I2C_0_MSTAT_XFER_INP
+#define I2C_1_MSTAT_ERR_XFER		I2C_0_MSTAT_ERR_XFER
+#define I2C_1_SM_MSTR_HALT			I2C_0_SM_MSTR_HALT
+#define I2C_1_SM_MSTR_WR_DATA		I2C_0_SM_MSTR_WR_DATA
+
+//The simulated bus completes every transfer instantly. The register macros
+//only have to let the hand-written byte functions (i2c.c, safety.c) finish.
+struct sim_i2c_regs_s
+{
+	reg8 data;
+	reg8 csr;
+	reg8 mcsr;
+	uint8 state;
+	uint8 mstrStatus;
+};
+extern struct sim_i2c_regs_s simI2cRegs[2];
+
+#define I2C_0_DATA_REG				(simI2cRegs[0].data)
+#define I2C_0_CSR_REG				(simI2cRegs[0].csr)
+#define I2C_0_MCSR_REG				(simI2cRegs[0].mcsr)
+#define I2C_0_state					(simI2cRegs[0].state)
+#define I2C_1_DATA_REG				(simI2cRegs[1].data)
+#define I2C_1_CSR_REG				(simI2cRegs[1].csr)
+#define I2C_1_MCSR_REG				(simI2cRegs[1].mcsr)
+#define I2C_1_state					(simI2cRegs[1].state)
+
+#define I2C_0_CHECK_MASTER_MODE(mcsr)		(1u)
+#define I2C_0_CHECK_BYTE_COMPLETE(csr)		(0u)
+#define I2C_0_WAIT_BYTE_COMPLETE(csr)		(0u)
+#define I2C_0_CHECK_DATA_ACK(csr)			(1u)
+#define I2C_0_TRANSMIT_DATA					do{simHalI2cAddrByte(0);}while(0)
+#define I2C_0_BUS_RELEASE					do{}while(0)
+#define I2C_1_CHECK_MASTER_MODE(mcsr)		(1u)
+#define I2C_1_CHECK_BYTE_COMPLETE(csr)		(0u)
+#define I2C_1_WAIT_BYTE_COMPLETE(csr)		(0u)
+#define I2C_1_CHECK_DATA_ACK(csr)			(1u)
+#define I2C_1_TRANSMIT_DATA					do{simHalI2cAddrByte(1);}while(0)
+#define I2C_1_BUS_RELEASE					do{}while(0)
+
+void simHalI2cAddrByte(uint8 bus);
+
+#define SIM_I2C_COMPONENT(name)																\
+	void name##_Start(void);																\
+	void name##_EnableInt(void);															\
+	uint8 name##_MasterSendStart(uint8 slaveAddress, uint8 R_nW);						\
+	uint8 name##_MasterWriteByte(uint8 theByte);											\
+	uint8 name##_MasterWriteBuf(uint8 slaveAddress, uint8 *wrData, uint8 cnt, uint8 mode);\
+	uint8 name##_MasterReadBuf(uint8 slaveAddress, uint8 *rdData, uint8 cnt, uint8 mode);	\
+	uint8 name##_MasterStatus(void);														\
+	uint8 name##_MasterClearStatus(void);													\
+	void name##_MasterClearWriteBuf(void);													\
+	void name##_MasterClearReadBuf(void);
+
+SIM_I2C_COMPONENT(I2C_0)
+SIM_I2C_COMPONENT(I2C_1)
+
+//****************************************************************************
+// Analog components:
+//****************************************************************************
+
+void ADC_SAR_1_Start(void);
+void ADC_SAR_1_StartConvert(void);
+void ADC_SAR_2_Start(void);
+void ADC_SAR_2_IRQ_Enable(void);
+void ADC_DelSig_1_Start(void);
+void ADC_DelSig_1_StartConvert(void);
+void ADC_DelSig_1_StopConvert(void);
+void ADC_DelSig_1_IRQ_Enable(void);
+void AMuxSeq_1_Start(void);
+void AMuxSeq_1_Next(void);
+int8 AMuxSeq_1_GetChannel(void);
+void VDAC8_1_Start(void);
+void Opamp_1_Start(void);
+void Opamp_2_Start(void);
+void Opamp_3_Start(void);
+void PGA_1_Start(void);
+void PGA_2_Start(void);
+void DieTemp_1_Start(void);
+cystatus DieTemp_1_Query(int16 *temperature);
+cystatus DieTemp_1_GetTemp(int16 *temperature);
+
+extern reg16 simAdcResultReg[3];
+#define ADC_SAR_1_SAR_WRK0_PTR		(&simAdcResultReg[0])
+#define ADC_SAR_2_SAR_WRK0_PTR		(&simAdcResultReg[1])
+//The model converts C, A & B together, at the PWM reload:
+#define ADC2_SAMPLE_SPACING_US		0
+#define ADC_DelSig_1_DEC_SAMP_PTR	(&simAdcResultReg[2])
+
+//****************************************************************************
+// Non-volatile memories:
+//****************************************************************************
+
+void EEPROM_1_Start(void);
+void EEPROM_1_UpdateTemperature(void);
+cystatus EEPROM_1_Write(const uint8 *rowData, uint8 rowNumber);
+uint8 EEPROM_1_ReadByte(uint16 address);
+void Em_EEPROM_1_Start(void);
+cystatus Em_EEPROM_1_Write(const uint8 *srcBuf, const uint8 *eepromPtr, uint16 byteCount);
+
+#endif	//SIM_PROJECT_H
@@ -0,0 +1,1165 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-execute' Advanced Motion Controller
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] sim_hal: PSoC HAL stand-in and virtual time base used by the
+	host simulation build.
+	Nothing here runs in real time. Code executes in zero virtual time, time
+	only moves when the main loop is idle (simHalIdle()) or when a function
+	busy waits (CyDelay()/CyDelayUs()). Peripheral events (Timer 1, PWM
+	reload, SPI frame, UART DMA, ...) are kept in a small table and fired in
+	chronological order. An event always updates the peripheral; its ISR
+	callback only runs if the ISR component was started and interrupts are
+	enabled. Callbacks can't nest: an event fired from a busy wait inside an
+	ISR is held until that ISR returns.
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-17 | agent | Initial release
+	*
+****************************************************************************/
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <time.h>
+#include "sim_hal.h"
+#include "sim_plant.h"
+#include "main.h"
+#include "cyapicallbacks.h"
+#include "analog.h"
+#include "current_sensing.h"
+#include "strain.h"
+#include "mem_angle.h"
+#include "sensor_commut.h"
+#include "safety.h"
+#include "imu.h"
+#include "mag_encoders.h"
+#include "fsm_timing.h"
+#include "control.h"
+#include "filters.h"
+#include "serial.h"
+#include "motor_id.h"
+#include "calibration_tools.h"
+
+//****************************************************************************
+// Variable(s)
+//****************************************************************************
+
+struct sim_stats_s simStats;
+
+//"Registers" referenced by the project.h macros:
+reg16 simPwmCompareReg[4];
+reg16 simSpimTxDataReg;
+reg8 simUartDataReg[4];
+reg16 simAdcResultReg[3];
+reg8 MotorDirection_Control;
+struct sim_i2c_regs_s simI2cRegs[2];
+
+//From motor.c:
+extern uint16_t myPWMcompareA, myPWMcompareB, myPWMcompareC;
+
+//Event table, in priority order (lowest index fires first on a tie):
+enum simEvent
+{
+	EV_PWM = 0,
+	EV_T1,
+	EV_SPI,
+	EV_T2,
+	EV_UART_TX,
+	EV_SAR1,
+	EV_DELSIG,
+	EV_I2C0,
+	EV_NUM
+};
+
+struct sim_event_s
+{
+	uint8 armed;
+	uint64 due;
+};
+
+static struct sim_event_s ev[EV_NUM];
+static uint64 nowNs = 0, plantNs = 0;
+static uint32 maxTicks = SIM_DEFAULT_TICKS;
+static uint32 cpuScale = 1;
+
+//Interrupt components:
+enum simIsr
+{
+	ISR_T1 = 0,
+	ISR_T2,
+	ISR_SAR1_DMA,
+	ISR_SAR2_DMA,
+	ISR_UART_RX,
+	ISR_UART_TX,
+	ISR_UART_BT_RX,
+	ISR_DELSIG,
+	ISR_SPI_TX,
+	ISR_MOT,
+	ISR_I2C0,
+	ISR_NUM
+};
+
+static uint8 isrEnabled[ISR_NUM];
+static uint32 isrPending = 0;
+static uint8 globalIntEnable = 0, inIsr = 0;
+
+//DMA channels, one per component, and transfer descriptors:
+enum simDmaChan
+{
+	DMA_CH_1 = 0,
+	DMA_CH_2,
+	DMA_CH_3,
+	DMA_CH_4,
+	DMA_CH_5,
+	DMA_CH_6,
+	DMA_CH_PA,
+	DMA_CH_PB,
+	DMA_CH_PC,
+	DMA_CH_NUM
+};
+
+#define SIM_DMA_TD_NUM		128
+
+struct sim_dma_td_s
+{
+	uint16 count;
+	uint8 next, config;
+	uint16 src, dst;
+};
+
+static uint8 dmaChEnabled[DMA_CH_NUM];
+static uint8 dmaChTd[DMA_CH_NUM];
+static struct sim_dma_td_s dmaTd[SIM_DMA_TD_NUM];
+static uint8 dmaTdCnt = DMA_CH_NUM;			//Below: working TDs (preserveTds)
+
+//Timers:
+static uint16 t1Period = 4000, t2Period = 400;
+
+//SPI:
+static uint8 spiIntMode = 0, spiTxQueued = 0;
+static uint16 spiRx = 0;
+
+//UART:
+static uint8 uartXmit = 0;
+
+//USB:
+#define SIM_USB_RX_LEN		512
+static uint8 usbRx[SIM_USB_RX_LEN];
+static uint16 usbRxLen = 0;
+
+//I2C, one 256 bytes register file per 7-bit address:
+static uint8 i2cMem[128][256];
+static uint8 i2cAddr[2], i2cPtr[2];
+static uint8 i2c0Done = 0;					//Status bit set at the end
+
+//IMU FIFO, 1kHz. Samples are copies of the data registers, with the sample
+//number in gyro X.
+static uint16 imuFifoBytes = 0;
+static uint32 imuFifoIn = 0, imuFifoOut = 0;	//Samples, bytes
+static uint64 imuFifoNs = 0;
+
+//EEPROM & analog:
+#define SIM_EEPROM_SIZE		2048
+static uint8 eeprom[SIM_EEPROM_SIZE];
+static int8 amuxCh = 0;
+static int32 qdecCounter = 0;
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static void simHalInit(void) __attribute__((constructor));
+static void simHalExit(void);
+static void dispatch(uint64 target);
+static void fireEvent(uint8 e);
+static void runIsr(uint8 isr);
+static void runPendingIsr(void);
+static void arm(uint8 e, uint64 delayNs);
+static void stepPlant(void);
+static void spiWrite(uint16 data);
+static void uartTxStart(void);
+static void i2cRefresh(uint8 addr);
+static void i2cXfer(uint8 bus, uint8 bytes, uint8 done);
+static uint8 i2cReadByte(uint8 bus);
+static void imuFifoRefresh(void);
+static int32 vbMv(void);
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+//Call from the main loop when there is nothing to do. Jumps to the next
+//Timer 1 interrupt. Returns 1 when the run is over (SIM_TICKS).
+uint8 simHalIdle(void)
+{
+	uint64 target = nowNs + 100000;
+
+	if(ev[EV_T1].armed)
+	{
+		target = ev[EV_T1].due;
+	}
+
+	dispatch(target);
+
+	return (simStats.t1Ticks >= maxTicks) ? 1 : 0;
+}
+
+uint64 simHalTimeNs(void)
+{
+	return nowNs;
+}
+
+uint32 simHalTimeUs(void)
+{
+	return (uint32)(nowNs / 1000);
+}
+
+//Host clock scaled to BCLK__BUS_CLK__HZ, stands in for the DWT cycle counter.
+//It measures the PC, not the PSoC: compare runs, not absolute numbers.
+//SIM_CPU_SCALE (host speed / target speed) gives a rough target estimate.
+//Busy waits (CyDelay()/CyDelayUs()) are added at the target speed.
+uint32 simHalCycleCount(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint32)(((uint64)ts.tv_sec * 1000000000ull + (uint64)ts.tv_nsec) * \
+					(BCLK__BUS_CLK__HZ / 1000000u) * cpuScale / 1000u + \
+					simStats.busyNs * (BCLK__BUS_CLK__HZ / 1000000u) / 1000u);
+}
+
+//Virtual time in BCLK__BUS_CLK__HZ cycles, for the sample timestamps
+uint32 simHalStampCycles(void)
+{
+	return (uint32)(nowNs * (BCLK__BUS_CLK__HZ / 1000000u) / 1000u);
+}
+
+//Moves time forward, firing everything that is due on the way:
+void simHalAdvanceNs(uint64 ns)
+{
+	dispatch(nowNs + ns);
+}
+
+//Bytes received by the USB CDC device (ie. sent by the GUI):
+void simHalUsbInject(const uint8 *buf, uint16 len)
+{
+	if(usbRxLen + len > SIM_USB_RX_LEN)
+		len = SIM_USB_RX_LEN - usbRxLen;
+
+	memcpy(&usbRx[usbRxLen], buf, len);
+	usbRxLen += len;
+}
+
+void simHalReport(void)
+{
+	printf("[sim] %.3fs virtual, %u ticks, %u PWM periods, %u SPI frames (%u interrupts)\n",
+			(double)nowNs * 1e-9, simStats.t1Ticks, simStats.pwmPeriods, simStats.spiFrames,
+			simStats.spiIsrs);
+	printf("[sim] I2C: %u reads, %u writes. RS-485: %u packets. USB: %u packets (%u bytes)\n",
+			simStats.i2cReads, simStats.i2cWrites, simStats.rs485Packets,
+			simStats.usbPackets, simStats.usbBytes);
+	printf("[sim] Busy wait: %.3fms. Motor: %.1f rad/s, %.3f Nm\n",
+			(double)simStats.busyNs * 1e-6, simPlant.omegaM, simPlantGetTorque());
+	#ifdef USE_FSM_TIMING
+	//Host cycles, scaled to BCLK__BUS_CLK__HZ (see readme.txt):
+	printf("[sim] CPU load: ISR %u, 10kHz %u, total %u per mil. ISR mean %u, p99 %u cycles (budget %u)\n",
+			fsmTimingCpuLoad(FSM_TIMING_ISR), fsmTimingCpuLoad(FSM_TIMING_10KHZ),
+			fsmTimingCpuLoadTotal(), fsmTimingMean(FSM_TIMING_ISR),
+			fsmTiming[FSM_TIMING_ISR].p99, FSM_TIMING_ISR_BUDGET);
+	#endif	//USE_FSM_TIMING
+
+	//Identified vs plant parameters:
+	if(getenv("SIM_MOTOR_ID") != NULL)
+	{
+		printf("[sim] Motor ID (plant): R %d (%.0f) mOhm, L %d (%.0f) uH, Ke %d (%.0f) uV/(rad/s), "
+				"J %d (%.0f) g.mm^2. Aborted: %d\n",
+				motorId.r, simPlant.r * 1e3, motorId.l, simPlant.l * 1e6, motorId.ke, simPlant.ke * 1e6,
+				motorId.j, simPlant.j * 1e9, motorId.aborted);
+		printf("[sim] Feed-forward (Q%d): R %d, back-EMF %d, L %d\n", MOTOR_ID_FF_SHIFT,
+				motorId.rFF, motorId.bemfFF, motorId.lFF);
+	}
+
+	//Current loop cost & CPU load per rate, with the final state of the run:
+	if(getenv("SIM_BENCH") != NULL)
+	{
+		current_loop_benchmark();
+		printf("[sim] Current loop: %u cycles/PWM period + %u cycles/PI. CPU load at 20/10/5kHz: %u/%u/%u per mil\n",
+				currentLoopBench.isrCycles, currentLoopBench.piCycles, currentLoopBench.loadPerMil[0],
+				currentLoopBench.loadPerMil[1], currentLoopBench.loadPerMil[2]);
+		filters_benchmark();
+		printf("[sim] 20Hz LPF at 10kHz, cycles (worst error, 1/1000 LSB): filt_array_10khz %u (%u), lpf1 %u (%u), biquad %u (%u)\n",
+				filtBench.legacyCycles, filtBench.legacyErr, filtBench.lpf1Cycles, filtBench.lpf1Err,
+				filtBench.biquadCycles, filtBench.biquadErr);
+		current_recip_benchmark();
+		printf("[sim] Sine current: divisions %u cycles, reciprocals %u cycles. Differences: %u/%u phase values, %u/%u samples\n",
+				currRecipBench.divCycles, currRecipBench.recipCycles, currRecipBench.pcomErrors,
+				currRecipBench.pcomChecked, currRecipBench.sampleErrors, currRecipBench.samples);
+		printf("[sim] Calibration procedures: %u wrong answers (0x06 legal: %u)\n",
+				test_legal_calibration_procedures(), isLegalCalibrationProcedure(0x06));
+		rs485_tx_benchmark();
+		printf("[sim] RS-485: rs485_puts() %u cycles, busy-wait sequence %u cycles (%d), %llu packets sent\n",
+				rs485BenchCycles, rs485BenchLegacyCycles,
+				(int)(rs485BenchLegacyCycles - rs485BenchCycles),
+				(unsigned long long)simStats.rs485Packets);
+	}
+}
+
+//cytypes.h / CyLib.h:
+//====================
+
+void simHalRegWrite(volatile void *addr, uint32 value, uint8 size)
+{
+	if(addr == (volatile void *)&simSpimTxDataReg)
+	{
+		spiWrite((uint16)value);
+		return;
+	}
+
+	switch(size)
+	{
+		case 1: *(reg8 *)addr = (uint8)value; break;
+		case 2: *(reg16 *)addr = (uint16)value; break;
+		default: *(reg32 *)addr = value; break;
+	}
+}
+
+void simHalIntEnable(uint8 en)
+{
+	globalIntEnable = en;
+	runPendingIsr();
+}
+
+void CyDelay(uint32 milliseconds)
+{
+	simStats.busyNs += (uint64)milliseconds * 1000000;
+	simHalAdvanceNs((uint64)milliseconds * 1000000);
+}
+
+void CyDelayUs(uint16 microseconds)
+{
+	simStats.busyNs += (uint64)microseconds * 1000;
+	simHalAdvanceNs((uint64)microseconds * 1000);
+}
+
+uint8 CyEnterCriticalSection(void)
+{
+	uint8 saved = globalIntEnable;
+	globalIntEnable = 0;
+	return saved;
+}
+
+void CyExitCriticalSection(uint8 savedIntrStatus)
+{
+	simHalIntEnable(savedIntrStatus);
+}
+
+//DMA (CyDmac.h). Data is moved by the events that own the channels, the
+//addresses are only kept for reference (LO16() of a host pointer is useless).
+//===========================================================================
+
+#define SIM_DMA_IMPL(name, chan)															\
+	uint8 name##_DmaInitialize(uint8 burstCount, uint8 requestPerBurst,					\
+								uint16 upperSrcAddress, uint16 upperDestAddress)		\
+	{																						\
+		(void)burstCount; (void)requestPerBurst;											\
+		(void)upperSrcAddress; (void)upperDestAddress;										\
+		return (chan);																		\
+	}
+
+SIM_DMA_IMPL(DMA_1, DMA_CH_1)
+SIM_DMA_IMPL(DMA_2, DMA_CH_2)
+SIM_DMA_IMPL(DMA_3, DMA_CH_3)
+SIM_DMA_IMPL(DMA_4, DMA_CH_4)
+SIM_DMA_IMPL(DMA_5, DMA_CH_5)
+SIM_DMA_IMPL(DMA_6, DMA_CH_6)
+SIM_DMA_IMPL(DMA_PA, DMA_CH_PA)
+SIM_DMA_IMPL(DMA_PB, DMA_CH_PB)
+SIM_DMA_IMPL(DMA_PC, DMA_CH_PC)
+
+uint8 CyDmaTdAllocate(void)
+{
+	if(dmaTdCnt >= SIM_DMA_TD_NUM)
+		return CY_DMA_DISABLE_TD;
+
+	return dmaTdCnt++;
+}
+
+cystatus CyDmaTdSetConfiguration(uint8 tdHandle, uint16 transferCount, uint8 nextTd, uint8 configuration)
+{
+	if(tdHandle >= SIM_DMA_TD_NUM)
+		return CYRET_BAD_PARAM;
+
+	dmaTd[tdHandle].count = transferCount;
+	dmaTd[tdHandle].next = nextTd;
+	dmaTd[tdHandle].config = configuration;
+	return CYRET_SUCCESS;
+}
+
+cystatus CyDmaTdGetConfiguration(uint8 tdHandle, uint16 *transferCount, uint8 *nextTd, uint8 *configuration)
+{
+	if(tdHandle >= SIM_DMA_TD_NUM)
+		return CYRET_BAD_PARAM;
+
+	*transferCount = dmaTd[tdHandle].count;
+	*nextTd = dmaTd[tdHandle].next;
+	*configuration = dmaTd[tdHandle].config;
+	return CYRET_SUCCESS;
+}
+
+cystatus CyDmaTdSetAddress(uint8 tdHandle, uint16 source, uint16 destination)
+{
+	if(tdHandle >= SIM_DMA_TD_NUM)
+		return CYRET_BAD_PARAM;
+
+	dmaTd[tdHandle].src = source;
+	dmaTd[tdHandle].dst = destination;
+	return CYRET_SUCCESS;
+}
+
+cystatus CyDmaChSetInitialTd(uint8 chHandle, uint8 startTd)
+{
+	if(chHandle >= DMA_CH_NUM)
+		return CYRET_BAD_PARAM;
+
+	dmaChTd[chHandle] = startTd;
+	return CYRET_SUCCESS;
+}
+
+cystatus CyDmaChEnable(uint8 chHandle, uint8 preserveTds)
+{
+	if(chHandle >= DMA_CH_NUM)
+		return CYRET_BAD_PARAM;
+
+	//Like the PHUB, the working copy of the TD is stored at the channel index
+	if(preserveTds && dmaChTd[chHandle] < SIM_DMA_TD_NUM)
+		dmaTd[chHandle] = dmaTd[dmaChTd[chHandle]];
+
+	dmaChEnabled[chHandle] = 1;
+	if(chHandle == DMA_CH_4 && uartXmit)
+		uartTxStart();
+
+	return CYRET_SUCCESS;
+}
+
+cystatus CyDmaChDisable(uint8 chHandle)
+{
+	if(chHandle >= DMA_CH_NUM)
+		return CYRET_BAD_PARAM;
+
+	dmaChEnabled[chHandle] = 0;
+	return CYRET_SUCCESS;
+}
+
+cystatus CyDmaClearPendingDrq(uint8 chHandle)
+{
+	(void)chHandle;
+	return CYRET_SUCCESS;
+}
+
+//Interrupt components:
+//=====================
+
+#define SIM_ISR_IMPL(name, isr)																\
+	void name##_Start(void) {isrEnabled[(isr)] = 1;}										\
+	void name##_Stop(void) {isrEnabled[(isr)] = 0;}										\
+	void name##_ClearPending(void) {isrPending &= ~(1u << (isr));}
+
+SIM_ISR_IMPL(isr_t1, ISR_T1)
+SIM_ISR_IMPL(isr_t2, ISR_T2)
+SIM_ISR_IMPL(isr_sar1_dma, ISR_SAR1_DMA)
+SIM_ISR_IMPL(isr_sar2_dma, ISR_SAR2_DMA)
+SIM_ISR_IMPL(isr_dma_uart_rx, ISR_UART_RX)
+SIM_ISR_IMPL(isr_dma_uart_tx, ISR_UART_TX)
+SIM_ISR_IMPL(isr_dma_uart_bt_rx, ISR_UART_BT_RX)
+SIM_ISR_IMPL(isr_delsig, ISR_DELSIG)
+SIM_ISR_IMPL(isr_spi_tx, ISR_SPI_TX)
+SIM_ISR_IMPL(isr_mot, ISR_MOT)
+
+//Pins & registers:
+//=================
+
+#define SIM_PIN_W_IMPL(name)	void name##_Write(uint8 value) {(void)value;}
+#define SIM_PIN_R_IMPL(name)	uint8 name##_Read(void) {return 0;}
+
+SIM_PIN_W_IMPL(LED_R)
+SIM_PIN_W_IMPL(LED_G)
+SIM_PIN_W_IMPL(LED_B)
+SIM_PIN_W_IMPL(LED_HB)
+SIM_PIN_W_IMPL(WDCLK)
+SIM_PIN_W_IMPL(DE)
+SIM_PIN_W_IMPL(NOT_RE)
+SIM_PIN_W_IMPL(T2_RESET)
+SIM_PIN_W_IMPL(EX2)
+SIM_PIN_W_IMPL(EX15)
+SIM_PIN_W_IMPL(Coast_Brake)
+SIM_PIN_W_IMPL(Control_Reg_1)
+SIM_PIN_W_IMPL(PWM_Kill)
+SIM_PIN_W_IMPL(Use_Hall)
+SIM_PIN_W_IMPL(Virtual_Hall)
+SIM_PIN_R_IMPL(EX1)
+SIM_PIN_R_IMPL(EX2)
+SIM_PIN_R_IMPL(EX3)
+SIM_PIN_R_IMPL(Status_Reg_1)
+
+void MotorDirection_Write(uint8 value) {MotorDirection_Control = value;}
+uint8 MotorDirection_Read(void) {return MotorDirection_Control;}
+
+//UART DMA request gate: transmission starts when it goes high
+void UART_DMA_XMIT_Write(uint8 value)
+{
+	uartXmit = value;
+	if(value && dmaChEnabled[DMA_CH_4])
+		uartTxStart();
+}
+
+//Timers:
+//=======
+
+void Timer_1_Init(void) {}
+void Timer_1_Start(void) {arm(EV_T1, (uint64)t1Period * (1000000000 / SIM_BUS_CLK_HZ));}
+void Timer_1_Stop(void) {ev[EV_T1].armed = 0;}
+void Timer_1_WritePeriod(uint16 period) {t1Period = period;}
+uint16 Timer_1_ReadPeriod(void) {return t1Period;}
+uint8 Timer_1_ReadStatusRegister(void) {return 0;}
+
+//Down counter, reloads at 0:
+uint16 Timer_1_ReadCounter(void)
+{
+	uint64 left = 0;
+
+	if(!ev[EV_T1].armed || ev[EV_T1].due < nowNs)
+		return 0;
+
+	left = (ev[EV_T1].due - nowNs) / (1000000000 / SIM_BUS_CLK_HZ);
+	return (uint16)left;
+}
+
+void Timer_2_Init(void) {}
+void Timer_2_Start(void) {arm(EV_T2, (uint64)t2Period * 1000000000ull / SIM_BUS_CLK_HZ);}
+void Timer_2_Stop(void) {ev[EV_T2].armed = 0;}
+void Timer_2_WritePeriod(uint16 period) {t2Period = period;}
+uint16 Timer_2_ReadPeriod(void) {return t2Period;}
+uint8 Timer_2_ReadStatusRegister(void) {return 0;}
+
+//PWM. Only the three phases of the sine commutation bridge are modeled.
+//======================================================================
+
+void PWM_A_Start(void) {arm(EV_PWM, SIM_PWM_PERIOD_NS); plantNs = nowNs;}
+void PWM_A_WriteCompare(uint16 compare) {simPwmCompareReg[0] = compare;}
+void PWM_B_Start(void) {}
+void PWM_B_WriteCompare(uint16 compare) {simPwmCompareReg[1] = compare;}
+void PWM_C_Start(void) {}
+void PWM_C_WriteCompare(uint16 compare) {simPwmCompareReg[2] = compare;}
+void PWM_1_Start(void) {}
+void PWM_1_WriteCompare1(uint16 compare) {simPwmCompareReg[3] = compare;}
+void PWM_1_WriteCompare2(uint16 compare) {(void)compare;}
+uint16 PWM_1_ReadCompare1(void) {return simPwmCompareReg[3];}
+void PWM_4_Start(void) {}
+void PWM_4_WriteCompare(uint8 compare) {(void)compare;}
+
+void QuadDec_1_Start(void) {}
+void QuadDec_1_Enable(void) {}
+void QuadDec_1_SetCounter(int32 value) {qdecCounter = value;}
+int32 QuadDec_1_GetCounter(void) {return qdecCounter;}
+
+void C8M_SetDividerValue(uint16 clkDivider) {(void)clkDivider;}
+
+//SPI Master. Every frame returns the encoder angle, sampled at the end
+//of the frame. Parity & error flags are always clear.
+//======================================================================
+
+void SPIM_1_Start(void) {}
+void SPIM_1_SetTxInterruptMode(uint8 intSrc) {spiIntMode = intSrc;}
+void SPIM_1_WriteTxData(uint16 txData) {spiWrite(txData);}
+uint16 SPIM_1_ReadRxData(void) {return spiRx;}
+uint8 SPIM_1_ReadTxStatus(void) {return SPIM_1_STS_SPI_DONE | SPIM_1_STS_BYTE_COMPLETE;}
+void SPIM_1_ClearFIFO(void) {spiTxQueued = 0;}
+
+//UARTs. RS-485 transmissions go through DMA_4, see uartTxStart().
+//================================================================
+
+void UART_1_Init(void) {}
+void UART_1_Enable(void) {}
+void UART_1_Start(void) {}
+void UART_1_PutArray(const uint8 string[], uint8 byteCount) {(void)string; (void)byteCount;}
+void UART_2_Init(void) {}
+void UART_2_Enable(void) {}
+void UART_2_Start(void) {}
+void UART_2_ClearTxBuffer(void) {}
+void UART_2_PutChar(uint8 txDataByte) {(void)txDataByte;}
+
+//USB CDC, always enumerated:
+//===========================
+
+void USBUART_1_Start(uint8 device, uint8 mode) {(void)device; (void)mode;}
+uint8 USBUART_1_GetConfiguration(void) {return 1;}
+void USBUART_1_CDC_Init(void) {}
+uint8 USBUART_1_DataIsReady(void) {return (usbRxLen > 0) ? 1 : 0;}
+uint8 USBUART_1_CDCIsReady(void) {return 1;}
+
+uint16 USBUART_1_GetAll(uint8 *pData)
+{
+	//One 64 bytes endpoint at the time:
+	uint16 len = (usbRxLen > 64) ? 64 : usbRxLen;
+
+	memcpy(pData, usbRx, len);
+	memmove(usbRx, &usbRx[len], usbRxLen - len);
+	usbRxLen -= len;
+
+	return len;
+}
+
+void USBUART_1_PutData(const uint8 *pData, uint16 length)
+{
+	(void)pData;
+	simStats.usbPackets++;
+	simStats.usbBytes += length;
+}
+
+//I2C masters. The data is moved right away; I2C_0 then takes the bus for
+//SIM_I2C_BYTE_NS per byte before its status & interrupt (component ISR exit
+//callback), I2C_1 completes instantly. The first byte written after a start
+//is the register address, reads auto-increment.
+//=========================================================================
+
+void simHalI2cAddrByte(uint8 bus)
+{
+	i2cPtr[bus] = simI2cRegs[bus].data;
+}
+
+#define SIM_I2C_IMPL(name, bus)																\
+	void name##_Start(void) {}																\
+	void name##_EnableInt(void) {if((bus) == 0) {isrEnabled[ISR_I2C0] = 1;}}				\
+	uint8 name##_MasterSendStart(uint8 slaveAddress, uint8 R_nW)							\
+	{																						\
+		(void)R_nW;																			\
+		i2cAddr[(bus)] = slaveAddress & 0x7F;												\
+		return I2C_0_MSTR_NO_ERROR;															\
+	}																						\
+	uint8 name##_MasterWriteByte(uint8 theByte)												\
+	{																						\
+		i2cMem[i2cAddr[(bus)]][i2cPtr[(bus)]++] = theByte;									\
+		return I2C_0_MSTR_NO_ERROR;															\
+	}																						\
+	uint8 name##_MasterWriteBuf(uint8 slaveAddress, uint8 *wrData, uint8 cnt, uint8 mode)	\
+	{																						\
+		uint8 i = 0;																		\
+		(void)mode;																			\
+		if(simI2cRegs[(bus)].mstrStatus & I2C_0_MSTAT_XFER_INP)								\
+			return I2C_0_MSTR_NOT_READY;													\
+		i2cAddr[(bus)] = slaveAddress & 0x7F;												\
+		simStats.i2cWrites++;																\
+		if(cnt > 0)																			\
+			i2cPtr[(bus)] = wrData[0];														\
+		for(i = 1; i < cnt; i++)															\
+			i2cMem[i2cAddr[(bus)]][i2cPtr[(bus)]++] = wrData[i];							\
+		i2cXfer((bus), cnt + 1, I2C_0_MSTAT_WR_CMPLT);										\
+		return I2C_0_MSTR_NO_ERROR;															\
+	}																						\
+	uint8 name##_MasterReadBuf(uint8 slaveAddress, uint8 *rdData, uint8 cnt, uint8 mode)	\
+	{																						\
+		uint8 i = 0;																		\
+		(void)mode;																			\
+		if(simI2cRegs[(bus)].mstrStatus & I2C_0_MSTAT_XFER_INP)								\
+			return I2C_0_MSTR_NOT_READY;													\
+		i2cAddr[(bus)] = slaveAddress & 0x7F;												\
+		simStats.i2cReads++;																\
+		i2cRefresh(i2cAddr[(bus)]);															\
+		for(i = 0; i < cnt; i++)															\
+			rdData[i] = i2cReadByte((bus));													\
+		i2cXfer((bus), cnt + 1, I2C_0_MSTAT_RD_CMPLT);										\
+		return I2C_0_MSTR_NO_ERROR;															\
+	}																						\
+	uint8 name##_MasterStatus(void) {return simI2cRegs[(bus)].mstrStatus;}					\
+	uint8 name##_MasterClearStatus(void)													\
+	{																						\
+		uint8 status = simI2cRegs[(bus)].mstrStatus;										\
+		simI2cRegs[(bus)].mstrStatus &= I2C_0_MSTAT_XFER_INP;								\
+		return status;																		\
+	}																						\
+	void name##_MasterClearWriteBuf(void) {}												\
+	void name##_MasterClearReadBuf(void) {}
+
+SIM_I2C_IMPL(I2C_0, 0)
+SIM_I2C_IMPL(I2C_1, 1)
+
+//Analog:
+//=======
+
+void ADC_SAR_1_Start(void) {}
+void ADC_SAR_1_StartConvert(void) {arm(EV_SAR1, 100000);}
+void ADC_SAR_2_Start(void) {}
+void ADC_SAR_2_IRQ_Enable(void) {}
+void ADC_DelSig_1_Start(void) {}
+void ADC_DelSig_1_StartConvert(void) {arm(EV_DELSIG, SIM_DELSIG_CONV_NS);}
+void ADC_DelSig_1_StopConvert(void) {ev[EV_DELSIG].armed = 0;}
+void ADC_DelSig_1_IRQ_Enable(void) {}
+void AMuxSeq_1_Start(void) {amuxCh = 0;}
+void AMuxSeq_1_Next(void) {amuxCh = (amuxCh + 1) % ADC1_CHANNELS;}
+int8 AMuxSeq_1_GetChannel(void) {return amuxCh;}
+void VDAC8_1_Start(void) {}
+void Opamp_1_Start(void) {}
+void Opamp_2_Start(void) {}
+void Opamp_3_Start(void) {}
+void PGA_1_Start(void) {}
+void PGA_2_Start(void) {}
+void DieTemp_1_Start(void) {}
+cystatus DieTemp_1_Query(int16 *temperature) {*temperature = 25; return CYRET_SUCCESS;}
+cystatus DieTemp_1_GetTemp(int16 *temperature) {*temperature = 25; return CYRET_SUCCESS;}
+
+//Non-volatile memories:
+//======================
+
+void EEPROM_1_Start(void) {}
+void EEPROM_1_UpdateTemperature(void) {}
+
+cystatus EEPROM_1_Write(const uint8 *rowData, uint8 rowNumber)
+{
+	if((uint16)(rowNumber + 1) * EE_ROW_LEN_BYTES > SIM_EEPROM_SIZE)
+		return CYRET_BAD_PARAM;
+
+	memcpy(&eeprom[rowNumber * EE_ROW_LEN_BYTES], rowData, EE_ROW_LEN_BYTES);
+	return CYRET_SUCCESS;
+}
+
+uint8 EEPROM_1_ReadByte(uint16 address)
+{
+	return (address < SIM_EEPROM_SIZE) ? eeprom[address] : 0;
+}
+
+void Em_EEPROM_1_Start(void) {}
+
+//The emulated EEPROM lives in flash (const arrays), unlock the pages first:
+cystatus Em_EEPROM_1_Write(const uint8 *srcBuf, const uint8 *eepromPtr, uint16 byteCount)
+{
+	uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+	uintptr_t start = (uintptr_t)eepromPtr & ~(page - 1);
+	uintptr_t end = ((uintptr_t)eepromPtr + byteCount + page - 1) & ~(page - 1);
+
+	if(mprotect((void *)start, end - start, PROT_READ | PROT_WRITE) != 0)
+		return CYRET_UNKNOWN;
+
+	memcpy((void *)eepromPtr, srcBuf, byteCount);
+	return CYRET_SUCCESS;
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+//Runs before main(): plant, EEPROM image & I2C devices
+static void simHalInit(void)
+{
+	uint16 anglemapInit[128];
+	uint16 i = 0, w = 0;
+	const char *ticks = getenv("SIM_TICKS");
+	const char *load = getenv("SIM_LOAD");
+	const char *cogging = getenv("SIM_COGGING");
+	const char *scale = getenv("SIM_CPU_SCALE");
+	const char *motorIdRun = getenv("SIM_MOTOR_ID");
+
+	if(ticks != NULL && atol(ticks) > 0)
+	{
+		maxTicks = (uint32)atol(ticks);
+	}
+	if(scale != NULL && atol(scale) > 0)
+	{
+		cpuScale = (uint32)atol(scale);
+	}
+
+	memset(&simStats, 0, sizeof(simStats));
+	simPlantInit();
+
+	//External torque, mNm:
+	if(load != NULL)
+	{
+		simPlant.tLoad = (double)atol(load) / 1000.0;
+	}
+	if(cogging != NULL)
+	{
+		simPlant.tCogging = (double)atol(cogging) / 1000.0;
+	}
+
+	//Motor identification from boot (it starts with the current zeroes):
+	if(motorIdRun != NULL)
+	{
+		calibrationFlags |= CALIBRATION_MOTOR_ID;
+	}
+
+	//Commutation table matching the plant, as if FINDPOLES had been run:
+	for(i = 0; i < NUMPOLES; i++)
+	{
+		anglemapInit[i] = simPlant.encOffset + (uint16)((16384 * (uint32)i + NUMPOLES / 2) / NUMPOLES);
+	}
+	anglemapInit[126] = 0;	//initpole
+	anglemapInit[127] = 1;
+	for(i = 0; i < 128; i++)
+	{
+		w = EE_ANGLE_COMM_START * EE_ROW_LEN_WORD + i;
+		eeprom[w << 1] = (anglemapInit[i] >> 8) & 0xFF;
+		eeprom[(w << 1) + 1] = anglemapInit[i] & 0xFF;
+	}
+
+	//IMU (MPU-6500): WHO_AM_I, 1g on Z
+	i2cMem[IMU_ADDR][117] = 0x70;
+	i2cMem[IMU_ADDR][IMU_ACCEL_XOUT_H + 4] = 0x20;
+
+	//Safety-CoP: battery voltage
+	i2cMem[SCOP_I2C_ADDR][MEM_R_VB_SNS] = SIM_SCOP_VB;
+
+	for(i = 0; i < 3; i++)
+	{
+		simPwmCompareReg[i] = PWM_AMP;
+	}
+
+	atexit(simHalExit);
+}
+
+static void simHalExit(void)
+{
+	simHalReport();
+}
+
+//Fire every event due up to 'target', in order, then set the time to 'target'
+static void dispatch(uint64 target)
+{
+	uint8 e = 0, next = EV_NUM;
+
+	while(1)
+	{
+		next = EV_NUM;
+		for(e = 0; e < EV_NUM; e++)
+		{
+			if(ev[e].armed && ev[e].due <= target)
+			{
+				if(next == EV_NUM || ev[e].due < ev[next].due)
+					next = e;
+			}
+		}
+
+		if(next == EV_NUM)
+			break;
+
+		if(ev[next].due > nowNs)
+			nowNs = ev[next].due;
+		ev[next].armed = 0;
+		fireEvent(next);
+	}
+
+	if(target > nowNs)
+		nowNs = target;
+}
+
+static void fireEvent(uint8 e)
+{
+	uint8 i = 0;
+	int32 amps = 0;
+
+	switch(e)
+	{
+		case EV_PWM:
+			//New compare values are latched at the reload:
+			stepPlant();
+			if(dmaChEnabled[DMA_CH_PA]) {simPwmCompareReg[0] = myPWMcompareA;}
+			if(dmaChEnabled[DMA_CH_PB]) {simPwmCompareReg[1] = myPWMcompareB;}
+			if(dmaChEnabled[DMA_CH_PC]) {simPwmCompareReg[2] = myPWMcompareC;}
+			simStats.pwmPeriods++;
+			arm(EV_PWM, SIM_PWM_PERIOD_NS);
+
+			//Current sensing (ADC SAR 2 is synchronized with the PWM). The
+			//sequence is C, A, B:
+			if(dmaChEnabled[DMA_CH_1])
+			{
+				for(i = 0; i < ADC2_BUF_LEN_3RD; i++)
+				{
+					amps = simPlantGetCurrentMa((i + 2) % 3);
+					adc_dma_array[i] = (int16)(SIM_ADC_ZERO + SIM_ISENSE_SIGN * amps / SIM_ADC_MA_PER_LSB);
+				}
+				simAdcResultReg[1] = (uint16)adc_dma_array[ADC2_BUF_LEN_3RD - 1];
+				runIsr(ISR_SAR2_DMA);
+			}
+
+			runIsr(ISR_MOT);
+			break;
+
+		case EV_T1:
+			simStats.t1Ticks++;
+			Timer_1_Start();
+			runIsr(ISR_T1);
+			break;
+
+		case EV_SPI:
+			stepPlant();
+			spiRx = simPlantGetEncoder();
+			simStats.spiFrames++;
+			if(spiTxQueued)
+			{
+				spiTxQueued--;
+				arm(EV_SPI, SIM_SPI_FRAME_NS);
+			}
+			if(spiIntMode)
+			{
+				runIsr(ISR_SPI_TX);
+			}
+			break;
+
+		case EV_T2:
+			runIsr(ISR_T2);
+			break;
+
+		case EV_UART_TX:
+			dmaChEnabled[DMA_CH_4] = 0;	//Next TD is CY_DMA_DISABLE_TD
+			simStats.rs485Packets++;
+			runIsr(ISR_UART_TX);
+			break;
+
+		case EV_SAR1:
+			if(dmaChEnabled[DMA_CH_5])
+			{
+				for(i = 0; i < ADC1_BUF_LEN; i++)
+				{
+					adc_sar1_dma_array[i] = SIM_ADC_ZERO;
+				}
+				runIsr(ISR_SAR1_DMA);
+			}
+			arm(EV_SAR1, 100000);
+			break;
+
+		case EV_I2C0:
+			simI2cRegs[0].mstrStatus = (simI2cRegs[0].mstrStatus & ~I2C_0_MSTAT_XFER_INP) | i2c0Done;
+			runIsr(ISR_I2C0);
+			break;
+
+		case EV_DELSIG:
+			if(dmaChEnabled[DMA_CH_2])
+			{
+				for(i = 0; i < 8; i++)
+				{
+					adc_delsig_dma_array[i] = 0x8000;
+				}
+			}
+			runIsr(ISR_DELSIG);
+			break;
+
+		default:
+			break;
+	}
+}
+
+static void runIsr(uint8 isr)
+{
+	if(!isrEnabled[isr])
+		return;
+
+	isrPending |= (1u << isr);
+	runPendingIsr();
+}
+
+//Lowest index first, same as the event priorities
+static void runPendingIsr(void)
+{
+	uint8 i = 0;
+
+	if(!globalIntEnable || inIsr)
+		return;
+
+	while(isrPending)
+	{
+		for(i = 0; i < ISR_NUM; i++)
+		{
+			if(isrPending & (1u << i))
+				break;
+		}
+		isrPending &= ~(1u << i);
+
+		inIsr = 1;
+		switch(i)
+		{
+			case ISR_T1: isr_t1_Interrupt_InterruptCallback(); break;
+			case ISR_T2: isr_t2_Interrupt_InterruptCallback(); break;
+			case ISR_SAR1_DMA: isr_sar1_dma_Interrupt_InterruptCallback(); break;
+			case ISR_SAR2_DMA: isr_sar2_dma_Interrupt_InterruptCallback(); break;
+			case ISR_UART_RX: isr_dma_uart_rx_Interrupt_InterruptCallback(); break;
+			case ISR_UART_TX: isr_dma_uart_tx_Interrupt_InterruptCallback(); break;
+			case ISR_UART_BT_RX: isr_dma_uart_bt_rx_Interrupt_InterruptCallback(); break;
+			case ISR_DELSIG: isr_delsig_Interrupt_InterruptCallback(); break;
+			case ISR_SPI_TX: simStats.spiIsrs++; isr_spi_tx_Interrupt_InterruptCallback(); break;
+			case ISR_MOT: isr_mot_Interrupt_InterruptCallback(); break;
+			#ifdef I2C_0_ISR_EXIT_CALLBACK
+			case ISR_I2C0: I2C_0_ISR_ExitCallback(); break;
+			#endif	//I2C_0_ISR_EXIT_CALLBACK
+			default: break;
+		}
+		inIsr = 0;
+	}
+}
+
+static void arm(uint8 e, uint64 delayNs)
+{
+	ev[e].armed = 1;
+	ev[e].due = nowNs + delayNs;
+}
+
+//Brings the motor model up to the current time
+static void stepPlant(void)
+{
+	uint16 cmp[3] = {simPwmCompareReg[0], simPwmCompareReg[1], simPwmCompareReg[2]};
+
+	if(nowNs > plantNs)
+	{
+		simPlantStep((uint32)(nowNs - plantNs), cmp, vbMv());
+		plantNs = nowNs;
+	}
+}
+
+//One 16-bit frame at the time, the others wait in the TX FIFO:
+static void spiWrite(uint16 data)
+{
+	simSpimTxDataReg = data;
+	if(ev[EV_SPI].armed)
+	{
+		spiTxQueued++;
+	}
+	else
+	{
+		arm(EV_SPI, SIM_SPI_FRAME_NS);
+	}
+}
+
+static void uartTxStart(void)
+{
+	uint8 td = dmaChTd[DMA_CH_4];
+
+	if(ev[EV_UART_TX].armed || td >= SIM_DMA_TD_NUM)
+		return;
+
+	arm(EV_UART_TX, (uint64)dmaTd[td].count * SIM_UART_BYTE_NS);
+}
+
+//Registers that follow the plant:
+static void i2cRefresh(uint8 addr)
+{
+	uint16 ang = 0;
+
+	if(addr == I2C_ADDR_AS5048B)
+	{
+		stepPlant();
+		ang = simPlantGetEncoder();
+		i2cMem[addr][AD5048B_REG_ANGLE_H] = (ang >> 6) & 0xFF;
+		i2cMem[addr][AD5048B_REG_ANGLE_H + 1] = ang & 0x3F;
+	}
+	else if(addr == IMU_ADDR)
+	{
+		imuFifoRefresh();
+	}
+}
+
+//Auto-increment, except for the IMU FIFO data register
+static uint8 i2cReadByte(uint8 bus)
+{
+	uint8 *reg = i2cMem[i2cAddr[bus]];
+	uint8 offset = 0, data = 0;
+
+	if(i2cAddr[bus] != IMU_ADDR || i2cPtr[bus] != IMU_FIFO_R_W)
+		return reg[i2cPtr[bus]++];
+
+	if(imuFifoBytes == 0)
+		return 0;
+
+	offset = imuFifoOut % IMU_BURST_LEN;
+	if(offset == 8 || offset == 9)
+		data = (uint8)((imuFifoOut / IMU_BURST_LEN) >> ((offset == 8) ? 8 : 0));
+	else
+		data = reg[IMU_ACCEL_XOUT_H + offset];
+
+	imuFifoOut++;
+	imuFifoBytes--;
+	reg[IMU_FIFO_COUNT_H] = imuFifoBytes >> 8;
+	reg[IMU_FIFO_COUNT_L] = imuFifoBytes & 0xFF;
+
+	return data;
+}
+
+//New samples since the last access. A full FIFO drops its oldest bytes.
+static void imuFifoRefresh(void)
+{
+	uint8 *reg = i2cMem[IMU_ADDR];
+	uint32 n = 0;
+
+	if(reg[IMU_USER_CTRL] & D_USER_CTRL_FIFO_RST)
+	{
+		reg[IMU_USER_CTRL] &= ~D_USER_CTRL_FIFO_RST;
+		imuFifoBytes = 0;
+		imuFifoOut = imuFifoIn * IMU_BURST_LEN;
+		imuFifoNs = nowNs;
+	}
+
+	if(!(reg[IMU_USER_CTRL] & D_USER_CTRL_FIFO_EN) || reg[IMU_FIFO_EN] != D_IMU_FIFO_EN)
+	{
+		imuFifoNs = nowNs;
+		return;
+	}
+
+	n = (uint32)((nowNs - imuFifoNs) / (IMU_FIFO_PERIOD_US * 1000));
+	imuFifoNs += (uint64)n * IMU_FIFO_PERIOD_US * 1000;
+	imuFifoIn += n;
+	if((uint32)imuFifoBytes + n * IMU_BURST_LEN > IMU_FIFO_SIZE)
+	{
+		imuFifoBytes = IMU_FIFO_SIZE;
+		imuFifoOut = imuFifoIn * IMU_BURST_LEN - IMU_FIFO_SIZE;
+	}
+	else
+	{
+		imuFifoBytes += n * IMU_BURST_LEN;
+	}
+
+	reg[IMU_FIFO_COUNT_H] = imuFifoBytes >> 8;
+	reg[IMU_FIFO_COUNT_L] = imuFifoBytes & 0xFF;
+}
+
+//Address byte included
+static void i2cXfer(uint8 bus, uint8 bytes, uint8 done)
+{
+	if(bus == 0)
+	{
+		simI2cRegs[0].mstrStatus |= I2C_0_MSTAT_XFER_INP;
+		i2c0Done = done;
+		arm(EV_I2C0, (uint64)bytes * SIM_I2C_BYTE_NS);
+	}
+	else
+	{
+		simI2cRegs[bus].mstrStatus |= done;
+	}
+}
+
+static int32 vbMv(void)
+{
+	return (int32)i2cMem[SCOP_I2C_ADDR][MEM_R_VB_SNS] * 176 + 9991;
+}
@@ -0,0 +1,97 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-execute' Advanced Motion Controller
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] sim_hal: PSoC HAL stand-in and virtual time base used by the
+	host simulation build
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-17 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_SIM_HAL_H
+#define INC_SIM_HAL_H
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <project.h>
+
+//****************************************************************************
+// Shared variable(s)
+//****************************************************************************
+
+//Statistics, read them at the end of a run:
+struct sim_stats_s
+{
+	uint32 t1Ticks;			//Timer 1 interrupts (100us)
+	uint32 pwmPeriods;		//PWM A reloads (isr_mot)
+	uint32 spiFrames;		//AS5047 words transferred
+	uint32 spiIsrs;			//AS5047 interrupts (isr_spi_tx)
+	uint32 i2cReads, i2cWrites;
+	uint32 rs485Packets, usbPackets;
+	uint32 usbBytes;
+	uint64 busyNs;			//Time spent in CyDelay()/CyDelayUs()
+};
+
+extern struct sim_stats_s simStats;
+
+//****************************************************************************
+// Prototype(s):
+//****************************************************************************
+
+uint8 simHalIdle(void);
+uint64 simHalTimeNs(void);
+uint32 simHalTimeUs(void);
+uint32 simHalCycleCount(void);
+uint32 simHalStampCycles(void);
+void simHalAdvanceNs(uint64 ns);
+void simHalUsbInject(const uint8 *buf, uint16 len);
+void simHalReport(void);
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+//Virtual clocks:
+#define SIM_BUS_CLK_HZ				40000000	//Timer_1 & 2 count at 40MHz
+#define SIM_PWM_PERIOD_NS			50000		//PWM A reload, 20kHz
+#define SIM_PWM_PERIOD_CLKS			990			//Matches PWM_MAX
+#define SIM_SPI_FRAME_NS			1600		//16 bits
+#define SIM_UART_BYTE_NS			5000		//2Mbaud, 10 bits
+#define SIM_I2C_BYTE_NS				22500		//400kHz, 9 bits (I2C_0 only)
+#define SIM_DELSIG_CONV_NS			1000000
+
+//Default run length, override with the SIM_TICKS environment variable:
+#define SIM_DEFAULT_TICKS			100000		//10s
+
+//Analog front-end:
+#define SIM_ADC_ZERO				2048
+#define SIM_ADC_MA_PER_LSB			16
+#define SIM_ISENSE_SIGN				(-1)		//ADC reading drops with a positive current
+
+//Safety-CoP battery reading (v_vb_mv = 80*176+9991 ~= 24V)
+#define SIM_SCOP_VB					80
+
+#endif	//INC_SIM_HAL_H
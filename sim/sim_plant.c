@@ -0,0 +1,172 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-execute' Advanced Motion Controller
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] sim_plant: BLDC motor, bridge and encoder model used by the
+	host simulation build. Average-value bridge (no switching ripple),
+	sinusoidal back-EMF, rigid rotor with viscous & Coulomb friction.
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-17 | agent | Initial release
+	*
+****************************************************************************/
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <math.h>
+#include "sim_plant.h"
+#include "sim_hal.h"
+
+//****************************************************************************
+// Variable(s)
+//****************************************************************************
+
+struct sim_plant_s simPlant;
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static double elecAngle(void);
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+//Default motor: 21 pole pairs (NUMPOLES = 126 sectors), ~100rpm/V
+void simPlantInit(void)
+{
+	uint8 i = 0;
+
+	simPlant.r = 0.186;
+	simPlant.l = 0.000140;
+	simPlant.ke = 0.0551;
+	simPlant.j = 0.00012;
+	simPlant.bViscous = 0.00001;
+	simPlant.tCoulomb = 0.005;
+	simPlant.tLoad = 0.0;
+	simPlant.tCogging = 0.0;
+	simPlant.polePairs = 21;
+	simPlant.encOffset = 50;
+
+	for(i = 0; i < 3; i++)
+	{
+		simPlant.i[i] = 0.0;
+		simPlant.vPhase[i] = 0.0;
+	}
+	simPlant.thetaM = 0.0;
+	simPlant.omegaM = 0.0;
+}
+
+//Integrates the model over dtNs with constant PWM compare values.
+//Phase B leads A by 120deg, C by 240deg (same order as COMM_PHASE_B/C)
+void simPlantStep(uint32 dtNs, const uint16 *cmp, int32 vbMv)
+{
+	double v[3], e[3], vAvg = 0.0, te = 0.0, tf = 0.0, tc = 0.0, dt = 0.0;
+	double th = 0.0;
+	uint8 k = 0;
+
+	//Bridge: duty cycle -> pole voltage, then neutral referenced
+	for(k = 0; k < 3; k++)
+	{
+		v[k] = ((double)vbMv / 1000.0) * (double)cmp[k] / (double)SIM_PWM_PERIOD_CLKS;
+		vAvg += v[k] / 3.0;
+	}
+	for(k = 0; k < 3; k++)
+	{
+		simPlant.vPhase[k] = v[k] - vAvg;
+	}
+
+	while(dtNs > 0)
+	{
+		dt = (double)((dtNs > SIM_PLANT_SUBSTEP_NS) ? SIM_PLANT_SUBSTEP_NS : dtNs) * 1e-9;
+		dtNs -= (dtNs > SIM_PLANT_SUBSTEP_NS) ? SIM_PLANT_SUBSTEP_NS : dtNs;
+
+		th = elecAngle();
+		te = 0.0;
+		for(k = 0; k < 3; k++)
+		{
+			e[k] = simPlant.ke * simPlant.omegaM * sin(th + (double)k * 2.0 * M_PI / 3.0);
+			te += simPlant.ke * simPlant.i[k] * sin(th + (double)k * 2.0 * M_PI / 3.0);
+			simPlant.i[k] += dt * (simPlant.vPhase[k] - simPlant.r * simPlant.i[k] - e[k]) / simPlant.l;
+		}
+
+		//Cogging, part of the 'external' torque:
+		tc = simPlant.tLoad - simPlant.tCogging * sin(SIM_COGGING_PERIODS * simPlant.thetaM);
+
+		//Friction (Coulomb term only opposes motion, or holds if it can):
+		tf = simPlant.bViscous * simPlant.omegaM;
+		if(simPlant.omegaM > 1e-6)
+			tf += simPlant.tCoulomb;
+		else if(simPlant.omegaM < -1e-6)
+			tf -= simPlant.tCoulomb;
+		else if(fabs(te + tc) <= simPlant.tCoulomb)
+			tf = te + tc;
+
+		simPlant.omegaM += dt * (te + tc - tf) / simPlant.j;
+		simPlant.thetaM += dt * simPlant.omegaM;
+		simPlant.thetaM = fmod(simPlant.thetaM, 2.0 * M_PI);
+		if(simPlant.thetaM < 0.0)
+			simPlant.thetaM += 2.0 * M_PI;
+	}
+}
+
+int32 simPlantGetCurrentMa(uint8 phase)
+{
+	if(phase > 2)
+		return 0;
+
+	return (int32)lround(simPlant.i[phase] * 1000.0);
+}
+
+//14-bit absolute angle, what the AS5047 returns
+uint16 simPlantGetEncoder(void)
+{
+	return (uint16)((uint32)(simPlant.thetaM * 16384.0 / (2.0 * M_PI)) & 0x3FFF);
+}
+
+//Electromagnetic torque at the current state, Nm
+double simPlantGetTorque(void)
+{
+	double th = elecAngle(), te = 0.0;
+	uint8 k = 0;
+
+	for(k = 0; k < 3; k++)
+	{
+		te += simPlant.ke * simPlant.i[k] * sin(th + (double)k * 2.0 * M_PI / 3.0);
+	}
+
+	return te;
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+static double elecAngle(void)
+{
+	double offset = (double)simPlant.encOffset * 2.0 * M_PI / 16384.0;
+
+	return (double)simPlant.polePairs * (simPlant.thetaM - offset);
+}
@@ -0,0 +1,88 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-execute' Advanced Motion Controller
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] sim_plant: BLDC motor, bridge and encoder model used by the
+	host simulation build
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-17 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_SIM_PLANT_H
+#define INC_SIM_PLANT_H
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <project.h>
+
+//****************************************************************************
+// Structure(s)
+//****************************************************************************
+
+struct sim_plant_s
+{
+	//Parameters (SI units, per phase, star connection):
+	double r, l;			//Ohm, H
+	double ke;				//Peak phase back-EMF, V/(rad/s) (mechanical)
+	double j;				//kg*m^2
+	double bViscous;		//Nm/(rad/s)
+	double tCoulomb;		//Nm
+	double tLoad;			//Nm, external torque applied to the shaft
+	double tCogging;		//Nm, amplitude of the cogging torque
+	uint8 polePairs;
+	uint16 encOffset;		//Encoder reading at electrical angle 0
+
+	//State:
+	double i[3];			//Phase currents, A
+	double thetaM;			//Mechanical angle, rad
+	double omegaM;			//Mechanical speed, rad/s
+	double vPhase[3];		//Last applied phase voltages (neutral referenced)
+};
+
+//****************************************************************************
+// Shared variable(s)
+//****************************************************************************
+
+extern struct sim_plant_s simPlant;
+
+//****************************************************************************
+// Prototype(s):
+//****************************************************************************
+
+void simPlantInit(void);
+void simPlantStep(uint32 dtNs, const uint16 *cmp, int32 vbMv);
+int32 simPlantGetCurrentMa(uint8 phase);
+uint16 simPlantGetEncoder(void);
+double simPlantGetTorque(void);
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+#define SIM_PLANT_SUBSTEP_NS		5000		//Euler step
+#define SIM_COGGING_PERIODS		18			//Cogging torque periods per turn
+
+#endif	//INC_SIM_PLANT_H
@@ -50,7 +50,36 @@ inline uint8_t isFindingCurrentZeroes()
 inline uint8_t isLegalCalibrationProcedure(uint8_t procedure)
 {
 	//ensure procedure is not out of bounds
-	//ensure procedure has only 1 bit true
-	return ((procedure == 1 || procedure % 2 == 0) && \
-		procedure <= CALIBRATION_FIND_CURRENT_ZEROES);
+	//ensure procedure has only 1 bit true (power of two)
+	return (procedure && !(procedure & (procedure - 1)) && \
+		procedure <= CALIBRATION_MOTOR_ID);
+}
+
+//****************************************************************************
+// Test Function(s) - Use with care!
+//****************************************************************************
+
+//Every 8-bit value against the list of single procedures. Returns the
+//number of wrong answers (0 = pass).
+uint8_t test_legal_calibration_procedures(void)
+{
+	const uint8_t legal[] = {CALIBRATION_FIND_POLES, CALIBRATION_FIND_CURRENT_ZEROES, \
+		CALIBRATION_COGGING, CALIBRATION_MOTOR_ID};
+	uint16_t p = 0;
+	uint8_t i = 0, expected = 0, errors = 0;
+
+	for(p = 0; p <= 0xFF; p++)
+	{
+		expected = 0;
+		for(i = 0; i < sizeof(legal); i++)
+		{
+			if(p == legal[i]) {expected = 1;}
+		}
+		if(!isLegalCalibrationProcedure((uint8_t)p) != !expected) {errors++;}
+	}
+
+	//Two procedures at once (current zeroes & cogging):
+	if(isLegalCalibrationProcedure(CALIBRATION_FIND_CURRENT_ZEROES | CALIBRATION_COGGING)) {errors++;}
+
+	return errors;
 }
@@ -0,0 +1,272 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-execute' Advanced Motion Controller
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] cogging: torque ripple map (calibration & current feed-forward)
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-17 | agent | Initial release
+	*
+****************************************************************************/
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include "main.h"
+#include "cogging.h"
+#include "mag_encoders.h"
+#include "mem_angle.h"
+#include "motor.h"
+#include "control.h"
+#include "flexsea_global_structs.h"
+#include <string.h>
+
+//****************************************************************************
+// Variable(s)
+//****************************************************************************
+
+struct cogging_s coggingCal;
+
+//Calibration: sum & count per bin, [0] forward, [1] reverse
+static int32_t cogSum[2][COGGING_BINS];
+static uint16_t cogCnt[2][COGGING_BINS];
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static uint8_t cogging_compute(void);
+#ifdef USE_FLASH
+static void cogging_save(void);
+static void cogging_load(void);
+#endif	//USE_FLASH
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+void init_cogging(void)
+{
+	memset(&coggingCal, 0, sizeof(coggingCal));
+
+	//Map from a previous calibration:
+	#ifdef USE_FLASH
+	init_flash();
+	cogging_load();
+	#endif	//USE_FLASH
+}
+
+//Run at 1kHz while CALIBRATION_COGGING is set (the controllers are off). The
+//rotor follows a slow ramp, forward then back; the current needed to follow
+//is recorded per bin. Friction changes sign with the direction, the cogging
+//doesn't: their average is the map. Returns 0 when done.
+uint8_t cogging_calibration(void)
+{
+	static int32_t setp = 0, end = 0, errSum = 0;
+	static uint16_t t = 0;
+	int32_t err = 0, v = 0;
+	uint8_t dir = 0, bin = 0;
+
+	switch(coggingCal.state)
+	{
+		case COG_IDLE:
+			memset(cogSum, 0, sizeof(cogSum));
+			memset(cogCnt, 0, sizeof(cogCnt));
+			setp = as5047.signed_ang;
+			errSum = 0;
+			t = 0;
+			coggingCal.aborted = 0;
+			coggingCal.state = COG_SETTLE;
+			break;
+		case COG_SETTLE:
+			if(++t >= COGGING_SETTLE_MS)
+			{
+				t = 0;
+				end = setp + COGGING_SWEEP;
+				coggingCal.state = COG_FWD;
+			}
+			break;
+		case COG_FWD:
+			setp += COGGING_SPEED;
+			if(setp >= end)
+			{
+				t = 0;
+				end = setp - COGGING_SWEEP;
+				coggingCal.state = COG_REV;
+			}
+			break;
+		case COG_REV:
+			setp -= COGGING_SPEED;
+			dir = 1;
+			if(setp <= end)
+			{
+				coggingCal.state = COG_DONE;
+			}
+			break;
+		default:
+			setMotorVoltage(0, 0);
+			if(cogging_compute())
+			{
+				#ifdef USE_FLASH
+				cogging_save();
+				#endif	//USE_FLASH
+			}
+			coggingCal.state = COG_IDLE;
+			return 0;
+	}
+
+	//Position PI, mV:
+	err = setp - as5047.signed_ang;
+	if(err > COGGING_MAX_ERR || err < -COGGING_MAX_ERR)
+	{
+		setMotorVoltage(0, 0);
+		coggingCal.aborted = 1;
+		coggingCal.state = COG_IDLE;
+		return 0;
+	}
+	errSum += err;
+	if(errSum > COGGING_MAX_ERR_SUM) {errSum = COGGING_MAX_ERR_SUM;}
+	if(errSum < -COGGING_MAX_ERR_SUM) {errSum = -COGGING_MAX_ERR_SUM;}
+	v = COGGING_KP * err + ((COGGING_KI * errSum) >> COGGING_KI_SHIFT);
+	setMotorVoltage(v, 0);
+
+	//Record, once the speed is steady:
+	if((coggingCal.state == COG_FWD || coggingCal.state == COG_REV) && (++t > COGGING_SKIP_MS))
+	{
+		bin = as5047.ang_abs_clks >> COGGING_BIN_SHIFT;
+		cogSum[dir][bin] += ctrl[0].current.actual_val;
+		cogCnt[dir][bin]++;
+	}
+
+	return 1;
+}
+
+//Feed-forward for the current controller, interpolated between bins
+int32_t cogging_ff(int32_t ang)
+{
+	uint16_t bin = 0, frac = 0;
+	int32_t a = 0, b = 0;
+
+	if(!coggingCal.valid)
+	{
+		return 0;
+	}
+
+	bin = (ang >> COGGING_BIN_SHIFT) & (COGGING_BINS - 1);
+	frac = ang & ((1 << COGGING_BIN_SHIFT) - 1);
+	a = coggingCal.map[bin];
+	b = coggingCal.map[(bin + 1) & (COGGING_BINS - 1)];
+
+	return a + (((b - a) * frac) >> COGGING_BIN_SHIFT);
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+//Map from the sums. Every bin needs samples in both directions.
+static uint8_t cogging_compute(void)
+{
+	int32_t fwd = 0, rev = 0, sum = 0, friction = 0, m = 0;
+	int32_t tmp[COGGING_BINS];
+	uint16_t i = 0;
+
+	for(i = 0; i < COGGING_BINS; i++)
+	{
+		if(cogCnt[0][i] == 0 || cogCnt[1][i] == 0)
+		{
+			return 0;
+		}
+		fwd = cogSum[0][i] / cogCnt[0][i];
+		rev = cogSum[1][i] / cogCnt[1][i];
+		tmp[i] = (fwd + rev) / 2;
+		friction += (fwd - rev) / 2;
+		sum += tmp[i];
+	}
+
+	//Zero mean (a constant load isn't cogging):
+	sum /= COGGING_BINS;
+	coggingCal.peak = 0;
+	for(i = 0; i < COGGING_BINS; i++)
+	{
+		m = tmp[i] - sum;
+		coggingCal.map[i] = (int16_t)m;
+		if(m < 0) {m = -m;}
+		if(m > coggingCal.peak) {coggingCal.peak = (int16_t)m;}
+	}
+	coggingCal.friction = (int16_t)(friction / COGGING_BINS);
+	coggingCal.valid = 1;
+
+	return 1;
+}
+
+#ifdef USE_FLASH
+
+static void cogging_save(void)
+{
+	uint16_t buf[COGGING_FLASH_WORDS];
+	uint16_t i = 0, n = 0;
+
+	for(i = 0; i < COGGING_BINS; i++)
+	{
+		buf[i] = (uint16_t)coggingCal.map[i];
+	}
+	buf[COGGING_BINS] = COGGING_MAGIC;
+
+	for(i = 0; i < COGGING_FLASH_WORDS; i += COGGING_FLASH_CHUNK)
+	{
+		n = COGGING_FLASH_WORDS - i;
+		if(n > COGGING_FLASH_CHUNK) {n = COGGING_FLASH_CHUNK;}
+		save_angles_to_flash(&buf[i], n, i / COGGING_FLASH_CHUNK);
+	}
+}
+
+static void cogging_load(void)
+{
+	uint16_t buf[COGGING_FLASH_WORDS];
+	uint16_t i = 0, n = 0;
+	int32_t m = 0;
+
+	for(i = 0; i < COGGING_FLASH_WORDS; i += COGGING_FLASH_CHUNK)
+	{
+		n = COGGING_FLASH_WORDS - i;
+		if(n > COGGING_FLASH_CHUNK) {n = COGGING_FLASH_CHUNK;}
+		load_angles_from_flash(&buf[i], n, i / COGGING_FLASH_CHUNK);
+	}
+
+	//Never calibrated:
+	if(buf[COGGING_BINS] != COGGING_MAGIC)
+	{
+		return;
+	}
+
+	for(i = 0; i < COGGING_BINS; i++)
+	{
+		coggingCal.map[i] = (int16_t)buf[i];
+		m = (coggingCal.map[i] < 0) ? -coggingCal.map[i] : coggingCal.map[i];
+		if(m > coggingCal.peak) {coggingCal.peak = (int16_t)m;}
+	}
+	coggingCal.valid = 1;
+}
+
+#endif	//USE_FLASH
@@ -43,6 +43,10 @@
 #include "trapez.h"
 #include "flexsea_global_structs.h"
 #include "mag_encoders.h"
+#include "current_sensing.h"
+#include "fsm_timing.h"
+#include "cogging.h"
+#include "motor_id.h"
 
 //****************************************************************************
 // Variable(s)
@@ -54,6 +58,9 @@ struct ctrl_s ctrl[2];
 //In Control tool:
 struct in_control_s in_control;
 
+//current_loop_benchmark() results:
+struct current_bench_s currentLoopBench;
+
 //****************************************************************************
 // Function(s)
 //****************************************************************************
@@ -283,25 +290,32 @@ inline int32 motor_current_pid_3(int32 wanted_curr, int32 measured_curr, uint8_t
 {
 	int32_t sign = 0;
 	
+	#ifdef USE_COGGING_COMP
+	//Torque ripple feed-forward (0 until calibrated):
+	wanted_curr += cogging_ff(as5047.ang_abs_clks);
+	#endif	//USE_COGGING_COMP
+	
 	//Error and integral of errors:
 	ctrl[ch].current.error = (wanted_curr - measured_curr);	//Actual error
 	ctrl[ch].current.error_sum += ctrl[ch].current.error;	//Cumulative error
 	
 	//Saturate cumulative error
-	if(ctrl[ch].current.error_sum >= MAX_CUM_CURRENT_ERROR)
-		ctrl[ch].current.error_sum = MAX_CUM_CURRENT_ERROR;
-	if(ctrl[ch].current.error_sum <= -MAX_CUM_CURRENT_ERROR)
-		ctrl[ch].current.error_sum = -MAX_CUM_CURRENT_ERROR;
+	if(ctrl[ch].current.error_sum >= CURRENT_MAX_ERR_SUM)
+		ctrl[ch].current.error_sum = CURRENT_MAX_ERR_SUM;
+	if(ctrl[ch].current.error_sum <= -CURRENT_MAX_ERR_SUM)
+		ctrl[ch].current.error_sum = -CURRENT_MAX_ERR_SUM;
 
 	//Proportional term
 	volatile int32 curr_p = (int)((ctrl[ch].current.gain.I_KP * ctrl[ch].current.error)>>8);
 	//Integral term
-	volatile int32 curr_i = (int)((ctrl[ch].current.gain.I_KI * ctrl[ch].current.error_sum)>>13);
+	volatile int32 curr_i = (int)((ctrl[ch].current.gain.I_KI * ctrl[ch].current.error_sum)>>CURRENT_KI_SHIFT);
 	//Add differential term here if needed
 	//In both cases we divide to get a finer gain adjustement w/ integer values.
 
 	//Output
-	volatile int32 curr_pwm = curr_p + curr_i + as5047.signed_ang_vel*37 + wanted_curr/10;
+	//Feed-forward: back-EMF & resistance (motor_id)
+	volatile int32 curr_pwm = curr_p + curr_i + \
+		((as5047.signed_ang_vel * motorId.bemfFF + wanted_curr * motorId.rFF) >> MOTOR_ID_FF_SHIFT);
 	
 	#if(MOTOR_COMMUT == COMMUT_SINE) 
 
@@ -338,6 +352,33 @@ inline int32 motor_current_pid_3(int32 wanted_curr, int32 measured_curr, uint8_t
 	return ctrl[ch].current.error;	
 }
 
+#ifdef CURRENT_LOOP_IN_ISR
+//Call from the SPI ISR, right after update_current_arrays(), before the
+//commutation. Uses the latest samples instead of actual_vals.avg (1kHz).
+//The PI runs once every 2^CURRENT_LOOP_DIV_SHIFT calls.
+void current_loop_isr(void)
+{
+	static int32_t buf[1 << CURRENT_ISR_AVG_SHIFT];
+	static int32_t sum = 0;
+	static uint8_t idx = 0, div = 0;
+	
+	sum += ctrl[0].current.actual_val - buf[idx];
+	buf[idx] = ctrl[0].current.actual_val;
+	idx = (idx + 1) & ((1 << CURRENT_ISR_AVG_SHIFT) - 1);
+	
+	div = (div + 1) & ((1 << CURRENT_LOOP_DIV_SHIFT) - 1);
+	if(div)
+	{
+		return;
+	}
+	
+	if((calibrationFlags == 0) && ((ctrl[0].active_ctrl == CTRL_CURRENT) || (ctrl[0].active_ctrl == CTRL_IMPEDANCE)))
+	{
+		motor_current_pid_3(ctrl[0].current.setpoint_val, sum >> CURRENT_ISR_AVG_SHIFT, 0);
+	}
+}
+#endif	//CURRENT_LOOP_IN_ISR
+
 //Impedance controller
 void impedance_controller(uint8_t ch)
 {
@@ -371,3 +412,52 @@ void in_control_get_pwm_dir(void)
 	in_control.mot_dir = 0;
 	#endif	//#if(MOTOR_COMMUT == COMMUT_BLOCK)
 }
+
+//****************************************************************************
+// Test Function(s) - Use with care!
+//****************************************************************************
+
+//Execution time of the ISR current path and CPU load at 20, 10 & 5kHz.
+//Results in currentLoopBench. Sends commutation values to the motor, with a
+//0 setpoint: keep it unloaded.
+void current_loop_benchmark(void)
+{
+	uint16_t i = 0;
+	uint8_t oldCtrl = ctrl[0].active_ctrl;
+	int32_t oldSetpoint = ctrl[0].current.setpoint_val;
+	uint32_t t0 = 0, cycles = 0;
+	
+	ctrl[0].active_ctrl = CTRL_CURRENT;
+	ctrl[0].current.setpoint_val = 0;
+	
+	//Every PWM period: current arrays & commutation
+	t0 = FSM_TIMING_NOW();
+	for(i = 0; i < CURRENT_BENCH_N; i++)
+	{
+		update_current_arrays();
+		sensor_sin_commut(as5047.ang_comp_clks >> 3, exec1.sine_commut_pwm);
+	}
+	cycles = FSM_TIMING_NOW() - t0;
+	currentLoopBench.isrCycles = cycles / CURRENT_BENCH_N;
+	
+	//Every loop period: PI & voltage
+	t0 = FSM_TIMING_NOW();
+	for(i = 0; i < CURRENT_BENCH_N; i++)
+	{
+		motor_current_pid_3(ctrl[0].current.setpoint_val, ctrl[0].current.actual_val, 0);
+	}
+	cycles = FSM_TIMING_NOW() - t0;
+	currentLoopBench.piCycles = cycles / CURRENT_BENCH_N;
+	
+	//Per mil of the CPU, for each CURRENT_LOOP_DIV_SHIFT:
+	for(i = 0; i < 3; i++)
+	{
+		currentLoopBench.loadPerMil[i] = (uint16_t)((((uint64_t)currentLoopBench.isrCycles * PWM_FREQ_HZ + \
+				(uint64_t)currentLoopBench.piCycles * (PWM_FREQ_HZ >> i)) * 1000) / BCLK__BUS_CLK__HZ);
+	}
+	
+	ctrl[0].current.error_sum = 0;
+	ctrl[0].current.setpoint_val = oldSetpoint;
+	ctrl[0].active_ctrl = oldCtrl;
+	setMotorVoltage(0, 0);
+}
@@ -37,7 +37,11 @@
 #include "sensor_commut.h"
 #include "mag_encoders.h"
 #include "filters.h"
+#include "fixed_math.h"
+#include "fsm_timing.h"
+#include "motor.h"
 #include "user-ex.h"
+#include <string.h>
 
 //****************************************************************************
 // Variable(s)
@@ -65,12 +69,40 @@ uint8_t DMA_1_TD[1];
 int64_t motor_currents[2] = {0,0};
 int64_t motor_currents_filt[2] = {0,0};
 
+//Motor current, running sum for the average:
+struct ringbuf_s currentRing;
+
+//Sine current reconstruction: reciprocal of |com| (RECIP_U32()), and 24/n for
+//the average of n phases
+static uint32_t pcomRecip[PWM_AMP + 1];
+static const int32_t pcomAvgMul[4] = {0, 24, 12, 8};
+struct curr_recip_bench_s currRecipBench;
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static int32_t sine_current_div(const int32_t *raw, int32_t vel, int32_t ang, const int32_t *us, int32_t prev);
+static int32_t sine_current_recip(const int32_t *raw, int32_t vel, int32_t ang, const int32_t *us, int32_t prev);
+static int32_t pcom_div(int32_t n, int32_t com);
+static int32_t div_1000(int32_t n);
+
 //****************************************************************************
 // Function(s)
 //****************************************************************************
 
 void initCurrentSensing(void)
 {
+	uint16_t i = 0;
+	
+	ringbuf_init(&currentRing, CURRENT_AVG_WINDOW);
+	
+	pcomRecip[0] = 0;
+	for(i = 1; i <= PWM_AMP; i++)
+	{
+		pcomRecip[i] = RECIP_U32(i, PCOM_RECIP_SHIFT);
+	}
+	
 	#if(MOTOR_COMMUT == COMMUT_BLOCK)
 	
 		//ADC2: Motor current
@@ -147,13 +179,11 @@ void update_current_arrays(void)
 	//the current is divided by (3)^.5 so that a user can multiply the current by the common line-to-line motor constant
 
 	static int64_t raw_current;
-	static int32 phase_a_raw, phase_b_raw, phase_c_raw;
-	static int32_t phase_a_ang, phase_b_ang, phase_c_ang;
-	static int32_t phase_a_com, phase_b_com, phase_c_com;
+	int32_t raw[3], us[3], adcUs = 0;
 	
-	phase_b_raw = (adc_dma_array_buf[2]-phase_b_zero);
-	phase_c_raw = (adc_dma_array_buf[0]-phase_c_zero);
-	phase_a_raw = (adc_dma_array_buf[1]-phase_a_zero);
+	raw[0] = (adc_dma_array_buf[1]-phase_a_zero);
+	raw[1] = (adc_dma_array_buf[2]-phase_b_zero);
+	raw[2] = (adc_dma_array_buf[0]-phase_c_zero);
 	
 	//Normal operation, or resistance measurement?
 	if(measure_motor_resistance)
@@ -168,43 +198,28 @@ void update_current_arrays(void)
 	
 	#if(MOTOR_COMMUT == COMMUT_SINE)
 		
-		phase_a_ang = ((((-60)*(as5047.filt_vel_cpms))/1000+(as5047.ang_abs_clks + lead)+16384)%16384);
-		phase_b_ang = ((((-10)*(as5047.filt_vel_cpms))/1000+(as5047.ang_abs_clks + lead)+16384)%16384);
-		phase_c_ang = ((((-110)*(as5047.filt_vel_cpms))/1000+(as5047.ang_abs_clks + lead)+16384)%16384);
+		//Time from the angle sample to each phase sample:
+		adcUs = STAMP_DIFF_US(sampleStamp.adc, sampleStamp.ang);
+		us[0] = adcUs - ADC2_AGE_A_US;
+		us[1] = adcUs - ADC2_AGE_B_US;
+		us[2] = adcUs - ADC2_AGE_C_US;
 		
-		phase_a_com = (int32_t)phaseAcoms[phase_a_ang>>3];
-		phase_b_com = (int32_t)phaseBcoms[phase_b_ang>>3];
-		phase_c_com = (int32_t)phaseCcoms[phase_c_ang>>3];
-		
-		static int32_t cursum,cursomcntr;
-		cursum = 0;
-		cursomcntr = 0;
-		
-		if(phase_a_com > PCOM_TH || phase_a_com < (-PCOM_TH))
-		{
-			cursum += (phase_a_raw * PCOM_G)/phase_a_com;
-			cursomcntr++;
-		}
-		if(phase_b_com > PCOM_TH || phase_b_com < (-PCOM_TH))
-		{
-			cursum += (phase_b_raw * PCOM_G)/phase_b_com;
-			cursomcntr++;
-		}
-		if(phase_c_com > PCOM_TH || phase_c_com < (-PCOM_TH))
-		{
-			cursum += (phase_c_raw * PCOM_G)/phase_c_com;
-			cursomcntr++;
-		}
-		
-		if(cursomcntr>0)
-		{
-			raw_current = -(24*cursum)/cursomcntr;
-		}
+		#ifdef USE_CURRENT_RECIP
+		raw_current = sine_current_recip(raw, as5047.filt_vel_cpms, as5047.ang_abs_clks + lead, us, raw_current);
+		#else
+		raw_current = sine_current_div(raw, as5047.filt_vel_cpms, as5047.ang_abs_clks + lead, us, raw_current);
+		#endif	//USE_CURRENT_RECIP
 		
 		//This is the amplitude of the current and should be multiplied by the phase torque constant or line-to-line constant / 3^.5
 		//x 16 mA/IU /2 samples * 3/2 for sum of 3 sin^2
 		//The amplitude of the current in each phase is raw_current / (3/2)
 		
+	#else
+		
+		(void)raw;
+		(void)us;
+		(void)adcUs;
+		
 	#endif
 	
 	#if((MOTOR_COMMUT == COMMUT_BLOCK) && (CURRENT_SENSING != CS_LEGACY))
@@ -230,7 +245,8 @@ void update_current_arrays(void)
 	//calculate the new filtered current
 	//the filter outputs raw values x 1024 in order to maintain precision
 	ctrl[0].current.actual_val = MOTOR_ORIENTATION*raw_current; // mAmps where I * the line-to-line motor constant = torque 
-	update_diffarr(&ctrl[0].current.actual_vals,ctrl[0].current.actual_val,50);
+	//History for actual_vals.avg (mainFSM8):
+	ringbuf_push(&currentRing, ctrl[0].current.actual_val);
 }
 
 void set_current_zero()
@@ -259,3 +275,153 @@ void adc_sar2_dma_reinit(void)
 {
 	CyDmaChSetInitialTd(DMA_1_Chan, DMA_1_TD[0]);
 }
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+//Sine commutation: current amplitude from the phases that are far enough from
+//a zero crossing (raw: A, B, C, ADC counts minus zero; ang: encoder + lead;
+//us: A, B, C sample times relative to the angle sample). Returns 'prev' if all
+//the phases are too small. Original version, 3 + 1 divisions & 3 x (/1000,
+//%16384).
+static int32_t sine_current_div(const int32_t *raw, int32_t vel, int32_t ang, const int32_t *us, int32_t prev)
+{
+	int32_t phase_a_ang, phase_b_ang, phase_c_ang;
+	int32_t phase_a_com, phase_b_com, phase_c_com;
+	int32_t cursum = 0, cursomcntr = 0;
+	
+	phase_a_ang = ((((us[0])*(vel))/1000+(ang)+16384)%16384);
+	phase_b_ang = ((((us[1])*(vel))/1000+(ang)+16384)%16384);
+	phase_c_ang = ((((us[2])*(vel))/1000+(ang)+16384)%16384);
+	
+	phase_a_com = COMM_SIN(commElecAng[phase_a_ang>>3]);
+	phase_b_com = COMM_SIN(commElecAng[phase_b_ang>>3] + COMM_PHASE_B);
+	phase_c_com = COMM_SIN(commElecAng[phase_c_ang>>3] + COMM_PHASE_C);
+	
+	if(phase_a_com > PCOM_TH || phase_a_com < (-PCOM_TH))
+	{
+		cursum += (raw[0] * PCOM_G)/phase_a_com;
+		cursomcntr++;
+	}
+	if(phase_b_com > PCOM_TH || phase_b_com < (-PCOM_TH))
+	{
+		cursum += (raw[1] * PCOM_G)/phase_b_com;
+		cursomcntr++;
+	}
+	if(phase_c_com > PCOM_TH || phase_c_com < (-PCOM_TH))
+	{
+		cursum += (raw[2] * PCOM_G)/phase_c_com;
+		cursomcntr++;
+	}
+	
+	if(cursomcntr>0)
+	{
+		return -(24*cursum)/cursomcntr;
+	}
+	
+	return prev;
+}
+
+//Same result, without divisions: pcomRecip[], div_1000(), pcomAvgMul[] (24 is
+//a multiple of 1, 2 & 3) and a mask (the angles are positive).
+static int32_t sine_current_recip(const int32_t *raw, int32_t vel, int32_t ang, const int32_t *us, int32_t prev)
+{
+	int32_t com[3];
+	int32_t cursum = 0, cnt = 0;
+	uint8_t i = 0;
+	
+	com[0] = COMM_SIN(commElecAng[((div_1000(us[0] * vel) + ang + 16384) & 0x3FFF) >> 3]);
+	com[1] = COMM_SIN(commElecAng[((div_1000(us[1] * vel) + ang + 16384) & 0x3FFF) >> 3] + COMM_PHASE_B);
+	com[2] = COMM_SIN(commElecAng[((div_1000(us[2] * vel) + ang + 16384) & 0x3FFF) >> 3] + COMM_PHASE_C);
+	
+	for(i = 0; i < 3; i++)
+	{
+		if(com[i] > PCOM_TH || com[i] < (-PCOM_TH))
+		{
+			cursum += pcom_div(raw[i] * PCOM_G, com[i]);
+			cnt++;
+		}
+	}
+	
+	return (cnt) ? -cursum * pcomAvgMul[cnt] : prev;
+}
+
+//n / com, truncated like the C division. |com| <= PWM_AMP, |n| < 2^22.
+static int32_t pcom_div(int32_t n, int32_t com)
+{
+	uint32_t un = (n < 0) ? -n : n;
+	int32_t q = (int32_t)RECIP_DIV(un, pcomRecip[(com < 0) ? -com : com], PCOM_RECIP_SHIFT);
+	
+	return ((n ^ com) < 0) ? -q : q;
+}
+
+//n / 1000, truncated like the C division. |n| < 2^31.
+static int32_t div_1000(int32_t n)
+{
+	uint32_t un = (n < 0) ? -n : n;
+	int32_t q = (int32_t)RECIP_DIV(un, RECIP_U32(1000, DIV1000_SHIFT), DIV1000_SHIFT);
+	
+	return (n < 0) ? -q : q;
+}
+
+//****************************************************************************
+// Test Function(s) - Use with care!
+//****************************************************************************
+
+//pcom_div() against the division for every raw value & phase value used, then
+//both reconstructions on random samples (cycles & differences). Results in
+//currRecipBench. Call after initCurrentSensing() & the commutation tables.
+void current_recip_benchmark(void)
+{
+	static int32_t raw[64][3], vel[64], ang[64];
+	//B 10us before the angle, like on the board:
+	const int32_t us[3] = {-10 - ADC2_AGE_A_US, -10 - ADC2_AGE_B_US, -10 - ADC2_AGE_C_US};
+	int32_t n = 0, com = 0, a = 0, b = 0;
+	uint32_t seed = 1, t0 = 0;
+	uint16_t i = 0;
+	uint8_t j = 0;
+	volatile int32_t sink = 0;
+	
+	memset(&currRecipBench, 0, sizeof(currRecipBench));
+	
+	//All the ADC values (+/- 12 bits) & phase values above the threshold:
+	for(n = -4095; n <= 4095; n++)
+	{
+		for(com = PCOM_TH + 1; com <= PWM_AMP; com++)
+		{
+			currRecipBench.pcomChecked += 2;
+			if(pcom_div(n * PCOM_G, com) != (n * PCOM_G) / com) {currRecipBench.pcomErrors++;}
+			if(pcom_div(n * PCOM_G, -com) != (n * PCOM_G) / (-com)) {currRecipBench.pcomErrors++;}
+		}
+	}
+	
+	//Random samples: currents, +/- 2000 counts/ms, any angle
+	for(i = 0; i < 64; i++)
+	{
+		for(j = 0; j < 3; j++)
+		{
+			seed = seed * 1664525 + 1013904223;
+			raw[i][j] = (int32_t)(seed >> 20) - 2048;
+		}
+		seed = seed * 1664525 + 1013904223;
+		vel[i] = (int32_t)(seed >> 21) - 1024;
+		seed = seed * 1664525 + 1013904223;
+		ang[i] = (int32_t)(seed >> 18);
+	}
+	
+	for(i = 0; i < CURR_RECIP_BENCH_N; i++)
+	{
+		a = sine_current_div(raw[i & 63], vel[i & 63] * (1 + (i >> 6)) / 32, ang[i & 63], us, 0);
+		b = sine_current_recip(raw[i & 63], vel[i & 63] * (1 + (i >> 6)) / 32, ang[i & 63], us, 0);
+		currRecipBench.samples++;
+		if(a != b) {currRecipBench.sampleErrors++;}
+	}
+	
+	t0 = FSM_TIMING_NOW();
+	for(i = 0; i < CURR_RECIP_BENCH_N; i++) {sink = sine_current_div(raw[i & 63], vel[i & 63], ang[i & 63], us, sink);}
+	currRecipBench.divCycles = (FSM_TIMING_NOW() - t0) / CURR_RECIP_BENCH_N;
+	t0 = FSM_TIMING_NOW();
+	for(i = 0; i < CURR_RECIP_BENCH_N; i++) {sink = sine_current_recip(raw[i & 63], vel[i & 63], ang[i & 63], us, sink);}
+	currRecipBench.recipCycles = (FSM_TIMING_NOW() - t0) / CURR_RECIP_BENCH_N;
+}
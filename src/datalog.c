@@ -0,0 +1,281 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-execute' Advanced Motion Controller
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] datalog: triggered high-rate logger (SPI ISR), RAM buffer
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-17 | agent | Initial release
+	*
+****************************************************************************/
+
+//The logger runs at the end of the SPI ISR (PWM_FREQ_HZ / decimation). Arm
+//it, wait for DATALOG_DONE, then read the DATALOG_LEN samples: trigger at
+//sample 'pre'. Streaming CMD_DATALOG reads the buffer in a loop.
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include "main.h"
+#include "datalog.h"
+#include "current_sensing.h"
+#include "mag_encoders.h"
+#include "motor.h"
+#include "foc.h"
+#include "user-ex.h"
+#include <string.h>
+#include <flexsea.h>
+#include <flexsea_payload.h>
+#include "flexsea_sys_def.h"
+#include "flexsea_global_structs.h"
+
+//****************************************************************************
+// Variable(s)
+//****************************************************************************
+
+struct datalog_s datalog;
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static int16_t sat16(int32_t x);
+static uint8_t datalog_trigger_check(int32_t err);
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+void initDatalog(void)
+{
+	memset(&datalog, 0, sizeof(datalog));
+	flexsea_multipayload_ptr[CMD_DATALOG][RX_PTYPE_READ] = &rx_multi_cmd_datalog_rr;
+}
+
+//'pre' samples before the trigger (max DATALOG_LEN - 1), one sample every
+//'decim' ISR calls (min 1). Restarts the capture.
+void datalog_arm(uint8_t source, int32_t threshold, uint16_t pre, uint8_t decim)
+{
+	datalog.state = DATALOG_IDLE;
+
+	datalog.source = source;
+	datalog.threshold = threshold;
+	datalog.pre = (pre < DATALOG_LEN) ? pre : (DATALOG_LEN - 1);
+	datalog.decim = (decim) ? decim : 1;
+	datalog.decimCnt = 0;
+	datalog.filled = 0;
+	datalog.head = 0;
+	datalog.start = 0;
+	datalog.force = 0;
+
+	datalog.state = DATALOG_ARMED;
+}
+
+//Triggers as soon as the pre-trigger window is full
+void datalog_trigger(void)
+{
+	datalog.force = 1;
+}
+
+void datalog_stop(void)
+{
+	datalog.state = DATALOG_IDLE;
+}
+
+//Call from the SPI ISR, after the commutation. Keep it short.
+void datalog_isr(void)
+{
+	struct datalog_s *d = &datalog;
+	struct datalog_sample_s *s;
+	int32_t err = 0;
+
+	if((d->state != DATALOG_ARMED) && (d->state != DATALOG_TRIGGERED))
+	{
+		return;
+	}
+
+	d->decimCnt++;
+	if(d->decimCnt < d->decim)
+	{
+		return;
+	}
+	d->decimCnt = 0;
+
+	#ifdef USE_FOC
+	err = foc.iqRef - foc.iq;
+	#else
+	err = ctrl[0].current.error;
+	#endif	//USE_FOC
+
+	s = &d->buf[d->head];
+	s->ia = (int16_t)(adc_dma_array[1] - phase_a_zero);
+	s->ib = (int16_t)(adc_dma_array[2] - phase_b_zero);
+	s->ic = (int16_t)(adc_dma_array[0] - phase_c_zero);
+	s->pwm[0] = myPWMcompareA;
+	s->pwm[1] = myPWMcompareB;
+	s->pwm[2] = myPWMcompareC;
+	s->ang = (uint16_t)as5047.ang_comp_clks;
+	s->err = sat16(err);
+	d->head = (d->head + 1) & DATALOG_MASK;
+
+	if(d->state == DATALOG_ARMED)
+	{
+		//This sample is the trigger if we have 'pre' samples before it
+		if(d->filled < d->pre)
+		{
+			d->filled++;
+			return;
+		}
+
+		if(datalog_trigger_check(err))
+		{
+			d->post = DATALOG_LEN - d->pre - 1;
+			d->state = DATALOG_TRIGGERED;
+		}
+	}
+	else
+	{
+		d->post--;
+	}
+
+	if((d->state == DATALOG_TRIGGERED) && (d->post == 0))
+	{
+		d->start = d->head;
+		d->state = DATALOG_DONE;
+	}
+}
+
+//Copies samples [first, first + n) of the capture to 'buf'. Returns the
+//number of samples copied (0 if the capture isn't done).
+uint8_t datalog_read(uint16_t first, uint8_t n, uint8_t *buf, uint16_t *index)
+{
+	struct datalog_sample_s *s;
+	uint8_t i = 0, j = 0;
+
+	if(datalog.state != DATALOG_DONE)
+	{
+		return 0;
+	}
+
+	for(i = 0; (i < n) && ((first + i) < DATALOG_LEN); i++)
+	{
+		s = &datalog.buf[(datalog.start + first + i) & DATALOG_MASK];
+		SPLIT_16((uint16_t)s->ia, buf, index);
+		SPLIT_16((uint16_t)s->ib, buf, index);
+		SPLIT_16((uint16_t)s->ic, buf, index);
+		for(j = 0; j < 3; j++)
+		{
+			SPLIT_16(s->pwm[j], buf, index);
+		}
+		SPLIT_16(s->ang, buf, index);
+		SPLIT_16((uint16_t)s->err, buf, index);
+	}
+
+	return i;
+}
+
+//Reply: state, pre (uint16), first sample (uint16), n, n x 16 bytes
+void rx_multi_cmd_datalog_rr(uint8_t *msgBuf, MultiPacketInfo *info, \
+								uint8_t *responseBuf, uint16_t* responseLen)
+{
+	static uint16_t nextSample = 0;
+	uint16_t index = 0, first = 0, pre = 0, i = 1;
+	uint8_t *nPtr;
+	int32_t th = 0;
+	(void)info;
+
+	switch(msgBuf[0])
+	{
+		case DATALOG_REQ_ARM:
+			i = 2;
+			th = (int32_t)REBUILD_UINT32(msgBuf, &i);
+			pre = REBUILD_UINT16(msgBuf, &i);
+			datalog_arm(msgBuf[1], th, pre, msgBuf[8]);
+			nextSample = 0;
+			break;
+		case DATALOG_REQ_TRIGGER:
+			datalog_trigger();
+			break;
+		case DATALOG_REQ_STOP:
+			datalog_stop();
+			break;
+		case DATALOG_REQ_READ:
+			first = REBUILD_UINT16(msgBuf, &i);
+			break;
+		default:
+			//Streaming: the next block, in a loop
+			first = nextSample;
+			break;
+	}
+
+	responseBuf[index++] = datalog.state;
+	SPLIT_16(datalog.pre, responseBuf, &index);
+	SPLIT_16(first, responseBuf, &index);
+	nPtr = &responseBuf[index++];
+	*nPtr = datalog_read(first, DATALOG_READ_SAMPLES, responseBuf, &index);
+
+	if(*nPtr && (msgBuf[0] == DATALOG_REQ_NEXT))
+	{
+		nextSample = first + *nPtr;
+		if(nextSample >= DATALOG_LEN) {nextSample = 0;}
+	}
+
+	*responseLen = index;
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+static int16_t sat16(int32_t x)
+{
+	if(x > INT16_MAX) {return INT16_MAX;}
+	if(x < INT16_MIN) {return INT16_MIN;}
+	return (int16_t)x;
+}
+
+static uint8_t datalog_trigger_check(int32_t err)
+{
+	int32_t x = 0;
+
+	if(datalog.force)
+	{
+		datalog.force = 0;
+		return 1;
+	}
+
+	switch(datalog.source)
+	{
+		case DATALOG_TRIG_ERR:
+			x = err;
+			break;
+		case DATALOG_TRIG_CURR:
+			x = ctrl[0].current.actual_val;
+			break;
+		default:
+			return 0;
+	}
+
+	if(x < 0) {x = -x;}
+	return (x >= datalog.threshold);
+}
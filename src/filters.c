@@ -33,6 +33,8 @@
 
 #include "main.h"
 #include "filters.h"
+#include "fixed_math.h"
+#include "fsm_timing.h"
 #include <flexsea_user_structs.h>
 
 //****************************************************************************
@@ -40,13 +42,15 @@
 //****************************************************************************
 
 //1st order Butterworth LPF coefficiencts for cutoff frequencies from 1 to 50
-int64_t as_10k[50] = {-65495,-65454,-65413,-65371,-65330,-65289,-65248,-65207,-65166,-65126,-65085,-65044,-65003,-64962,-64921,-64880,-64840,-64799,-64758,-64718,-64677,-64636,-64596,-64555,-64515,-64474,-64434,-64393,-64353,-64312,-64272,-64231,-64191,-64151,-64110,-64070,-64030,-63990,-63949,-63909,-63869,-63829,-63789,-63749,-63709,-63669,-63629,-63589,-63549,-63509};
-int64_t bs_10k[50] = {21076,42139,63189,84226,105249,126259,147257,168240,189211,210169,231114,252045,272964,293870,314762,335642,356508,377362,398202,419030,439845,460647,481436,502212,522975,543726,564463,585188,605900,626599,647286,667959,688620,709269,729904,750527,771137,791735,812320,832892,853452,873999,894534,915056,935565,956062,976547,997019,1017478,1037925};
-int64_t as_1k[50] = {-32563,-32359,-32156,-31955,-31754,-31555,-31358,-31161,-30965,-30771,-30578,-30386,-30195,-30005,-29817,-29629,-29442,-29257,-29072,-28889,-28706,-28525,-28345,-28165,-27987,-27809,-27632,-27457,-27282,-27108,-26935,-26763,-26592,-26422,-26252,-26084,-25916,-25749,-25583,-25417,-25253,-25089,-24926,-24764,-24603,-24442,-24282,-24123,-23965,-23807};
-int64_t bs_1k[50] = {3284,6547,9791,13014,16218,19402,22567,25713,28840,31949,35039,38112,41166,44203,47223,50225,53210,56179,59131,62066,64985,67888,70776,73647,76504,79345,82171,84982,87778,90559,93326,96079,98818,101543,104254,106952,109636,112306,114964,117609,120240,122859,125466,128060,130641,133211,135769,138314,140848,143370};
-int64_t as_250[50] = {-7989,-7790,-7597,-7407,-7222,-7041,-6864,-6691,-6521,-6354,-6191,-6031,-5874,-5719,-5567,-5418,-5271,-5127,-4985,-4845,-4707,-4571,-4437,-4305,-4174,-4045,-3918,-3792,-3668,-3545,-3423,-3303,-3184,-3066,-2949,-2834,-2719,-2605,-2492,-2380,-2269,-2158,-2049,-1940,-1831,-1723,-1616,-1509,-1403,-1297};
-int64_t bs_250[50] = {813,1607,2382,3139,3879,4603,5311,6005,6684,7351,8004,8645,9274,9892,10499,11096,11683,12260,12829,13389,13941,14485,15021,15550,16072,16587,17096,17599,18096,18588,19074,19555,20032,20504,20971,21434,21893,22348,22800,23248,23693,24135,24574,25010,25443,25875,26304,26730,27155,27578};
+//Hz, generated at compile time (filters.h)
+const int32_t as_10k[50] = {FILT_FC_1_50(FILT_TABLE_A, 10000, 16)};
+const int32_t bs_10k[50] = {FILT_FC_1_50(FILT_TABLE_B, 10000, 26)};
+const int32_t as_1k[50] = {FILT_FC_1_50(FILT_TABLE_A, 1000, 15)};
+const int32_t bs_1k[50] = {FILT_FC_1_50(FILT_TABLE_B, 1000, 20)};
+const int32_t as_250[50] = {FILT_FC_1_50(FILT_TABLE_A, 250, 13)};
+const int32_t bs_250[50] = {FILT_FC_1_50(FILT_TABLE_B, 250, 16)};
 
+struct filt_bench_s filtBench;
 
 //****************************************************************************
 // Function(s)
@@ -55,6 +59,7 @@ int64_t bs_250[50] = {813,1607,2382,3139,3879,4603,5311,6005,6684,7351,8004,8645
 //Filters raw signal at cut_off frequency if sampled at 10 kHz
 //filt is 1024 x raw in order to maintain precision
 //this function also shifts the arrays
+//raw values must fit in 32 bits (32x32 multiply), filt stays 64-bit
 int32_t filt_array_10khz(int64_t * raw, int64_t * filt, int cut_off, int64_t new_raw)
 {
 	
@@ -67,7 +72,7 @@ int32_t filt_array_10khz(int64_t * raw, int64_t * filt, int cut_off, int64_t new
 	else if (cut_off>50)
 	cut_off = 50;
 	
-	filt[0] = (bs_10k[cut_off-1]*(raw[1]+raw[0])-as_10k[cut_off-1]*filt[1])>>16;   
+	filt[0] = ((int64_t)bs_10k[cut_off-1]*(int32_t)(raw[1]+raw[0])-as_10k[cut_off-1]*filt[1])>>16;   
 	return (int32_t)(filt[0]>>10);
 }
 
@@ -85,7 +90,7 @@ int32_t filt_array_1khz(int64_t * raw, int64_t * filt, int cut_off, int64_t new_
 	else if (cut_off>50)
 	cut_off = 50;
 	
-	filt[0] = (bs_1k[cut_off-1]*(raw[1]+raw[0])-as_1k[cut_off-1]*filt[1])>>15;   
+	filt[0] = ((int64_t)bs_1k[cut_off-1]*(int32_t)(raw[1]+raw[0])-as_1k[cut_off-1]*filt[1])>>15;   
 	return (int32_t)(filt[0]>>5);
 }
 
@@ -103,7 +108,7 @@ int32_t filt_array_250hz(int64_t * raw, int64_t * filt, int cut_off, int64_t new
 	else if (cut_off>50)
 	cut_off = 50;
 	
-	filt[0] = (bs_250[cut_off-1]*(raw[1]+raw[0])-as_250[cut_off-1]*filt[1])>>13;   
+	filt[0] = ((int64_t)bs_250[cut_off-1]*(int32_t)(raw[1]+raw[0])-as_250[cut_off-1]*filt[1])>>13;   
 	return (int32_t)(filt[0]>>3);
 }
 
@@ -131,7 +136,7 @@ void filt_array_1khz_struct(struct filtvar_s *fv, int cut_off)
 	else if (cut_off>50)
 	cut_off = 50;
 	
-	fv->filts[0] = (bs_1k[cut_off-1]*(fv->raws[1]+fv->raws[0])-as_1k[cut_off-1]*fv->filts[1])>>15;
+	fv->filts[0] = ((int64_t)bs_1k[cut_off-1]*(int32_t)(fv->raws[1]+fv->raws[0])-as_1k[cut_off-1]*fv->filts[1])>>15;
 	fv->filt = (int32_t)(fv->filts[0]>>5);
 }
 
@@ -178,3 +183,132 @@ int32_t get_vel_1k_5samples_downsampled(struct diffarr_s * das)
 	}
 	return accsum/10; // /10
 }
+
+//Starts the filter in steady state at 'x' (unity DC gain)
+void lpf1_reset(struct lpf1_s *f, int32_t x)
+{
+	f->x1 = x;
+	f->y1 = x;
+	f->err = 0;
+}
+
+//1st order filter object, see LPF1_INIT(). The fraction lost by the >> is
+//fed back to the next sample: 32-bit state, no drift.
+int32_t lpf1_run(struct lpf1_s *f, int32_t x)
+{
+	int64_t acc = f->err;
+	int32_t y = 0;
+	
+	acc += (int64_t)f->b * (x + f->x1);
+	acc -= (int64_t)f->a * f->y1;
+	y = (int32_t)(acc >> FILT_COEF_Q);
+	f->err = (int32_t)(acc - ((int64_t)y << FILT_COEF_Q));
+	
+	f->x1 = x;
+	f->y1 = y;
+	return y;
+}
+
+void biquad_reset(struct biquad_s *f, int32_t x)
+{
+	f->x1 = x;
+	f->x2 = x;
+	f->y1 = x;
+	f->y2 = x;
+	f->err1 = 0;
+	f->err2 = 0;
+}
+
+//Biquad, direct form I, see BIQUAD_LPF_INIT(). With poles close to 1, the
+//rounding noise is amplified by 1/(1+a1+a2): 2nd order error feedback
+//cancels it (~1 LSB instead of ~20 at fs/500).
+int32_t biquad_run(struct biquad_s *f, int32_t x)
+{
+	int64_t acc = 2 * (int64_t)f->err1 - f->err2;
+	int32_t y = 0;
+	
+	acc += (int64_t)f->b0 * x;
+	acc += (int64_t)f->b1 * f->x1;
+	acc += (int64_t)f->b2 * f->x2;
+	acc -= (int64_t)f->a1 * f->y1;
+	acc -= (int64_t)f->a2 * f->y2;
+	y = (int32_t)(acc >> FILT_COEF_Q);
+	f->err2 = f->err1;
+	f->err1 = (int32_t)(acc - ((int64_t)y << FILT_COEF_Q));
+	
+	f->x2 = f->x1;
+	f->x1 = x;
+	f->y2 = f->y1;
+	f->y1 = y;
+	return y;
+}
+
+//****************************************************************************
+// Test Function(s) - Use with care!
+//****************************************************************************
+
+//20Hz LPF at 10kHz: filt_array_10khz() vs lpf1_run() vs biquad_run(). Input:
+//step, 5Hz sine & noise. Cycles per call (loop included), and the worst
+//error against the same filters in double precision. Results in filtBench.
+void filters_benchmark(void)
+{
+	static int32_t in[256];
+	int64_t raw[2] = {0, 0}, filt[2] = {0, 0};
+	struct lpf1_s lpf = LPF1_INIT(20, 10000);
+	struct biquad_s bq = BIQUAD_LPF_INIT(20, 10000);
+	const double b = LPF1_B(20, 10000), a = LPF1_A(20, 10000);
+	const double b0 = BQ_LPF_B0(20, 10000), a1 = BQ_LPF_A1(20, 10000), a2 = BQ_LPF_A2(20, 10000);
+	double r1 = 0.0, x1 = 0.0, q1 = 0.0, q2 = 0.0, x2 = 0.0, ref = 0.0, d = 0.0;
+	double e0 = 0.0, e1 = 0.0, e2 = 0.0;
+	uint32_t seed = 1, t0 = 0;
+	uint16_t i = 0;
+	int32_t y0 = 0, y1 = 0, y2 = 0;
+	volatile int32_t sink = 0;
+	
+	for(i = 0; i < 256; i++)
+	{
+		seed = seed * 1664525 + 1013904223;
+		in[i] = 10000 + (sin_q15((uint16_t)(i << 8)) >> 4) + (int32_t)(seed >> 23) - 256;
+	}
+	
+	//Cycles:
+	t0 = FSM_TIMING_NOW();
+	for(i = 0; i < FILT_BENCH_N; i++) {sink = filt_array_10khz(raw, filt, 20, in[i & 255]);}
+	filtBench.legacyCycles = (FSM_TIMING_NOW() - t0) / FILT_BENCH_N;
+	t0 = FSM_TIMING_NOW();
+	for(i = 0; i < FILT_BENCH_N; i++) {sink = lpf1_run(&lpf, in[i & 255]);}
+	filtBench.lpf1Cycles = (FSM_TIMING_NOW() - t0) / FILT_BENCH_N;
+	t0 = FSM_TIMING_NOW();
+	for(i = 0; i < FILT_BENCH_N; i++) {sink = biquad_run(&bq, in[i & 255]);}
+	filtBench.biquadCycles = (FSM_TIMING_NOW() - t0) / FILT_BENCH_N;
+	(void)sink;
+	
+	//Error, from a zero state (step at i = 0):
+	raw[0] = 0; raw[1] = 0; filt[0] = 0; filt[1] = 0;
+	lpf1_reset(&lpf, 0);
+	biquad_reset(&bq, 0);
+	for(i = 0; i < FILT_BENCH_N; i++)
+	{
+		y0 = filt_array_10khz(raw, filt, 20, in[i & 255]);
+		y1 = lpf1_run(&lpf, in[i & 255]);
+		y2 = biquad_run(&bq, in[i & 255]);
+		
+		ref = b * (in[i & 255] + x1) - a * r1;
+		d = (y0 > ref) ? (y0 - ref) : (ref - y0);
+		if(d > e0) {e0 = d;}
+		d = (y1 > ref) ? (y1 - ref) : (ref - y1);
+		if(d > e1) {e1 = d;}
+		r1 = ref;
+		
+		ref = b0 * (in[i & 255] + 2.0 * x1 + x2) - a1 * q1 - a2 * q2;
+		d = (y2 > ref) ? (y2 - ref) : (ref - y2);
+		if(d > e2) {e2 = d;}
+		q2 = q1;
+		q1 = ref;
+		x2 = x1;
+		x1 = in[i & 255];
+	}
+	filtBench.legacyErr = (uint32_t)(e0 * 1000.0);
+	filtBench.lpf1Err = (uint32_t)(e1 * 1000.0);
+	filtBench.biquadErr = (uint32_t)(e2 * 1000.0);
+}
@@ -0,0 +1,191 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-execute' Advanced Motion Controller
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] fixed_math: integer trigonometry (no FPU on the Cortex-M3)
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-17 | agent | Initial release
+	*
+****************************************************************************/
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include "main.h"
+#include "fixed_math.h"
+
+//****************************************************************************
+// Variable(s)
+//****************************************************************************
+
+//round(32767*sin(i*pi/512)), i = 0..256 (first quadrant, in Flash)
+const int16_t sinQ15Table[(1 << SIN_Q15_TABLE_BITS) + 1] =
+{
+	    0,   201,   402,   603,   804,  1005,  1206,  1407,
+	 1608,  1809,  2009,  2210,  2410,  2611,  2811,  3012,
+	 3212,  3412,  3612,  3811,  4011,  4210,  4410,  4609,
+	 4808,  5007,  5205,  5404,  5602,  5800,  5998,  6195,
+	 6393,  6590,  6786,  6983,  7179,  7375,  7571,  7767,
+	 7962,  8157,  8351,  8545,  8739,  8933,  9126,  9319,
+	 9512,  9704,  9896, 10087, 10278, 10469, 10659, 10849,
+	11039, 11228, 11417, 11605, 11793, 11980, 12167, 12353,
+	12539, 12725, 12910, 13094, 13279, 13462, 13645, 13828,
+	14010, 14191, 14372, 14553, 14732, 14912, 15090, 15269,
+	15446, 15623, 15800, 15976, 16151, 16325, 16499, 16673,
+	16846, 17018, 17189, 17360, 17530, 17700, 17869, 18037,
+	18204, 18371, 18537, 18703, 18868, 19032, 19195, 19357,
+	19519, 19680, 19841, 20000, 20159, 20317, 20475, 20631,
+	20787, 20942, 21096, 21250, 21403, 21554, 21705, 21856,
+	22005, 22154, 22301, 22448, 22594, 22739, 22884, 23027,
+	23170, 23311, 23452, 23592, 23731, 23870, 24007, 24143,
+	24279, 24413, 24547, 24680, 24811, 24942, 25072, 25201,
+	25329, 25456, 25582, 25708, 25832, 25955, 26077, 26198,
+	26319, 26438, 26556, 26674, 26790, 26905, 27019, 27133,
+	27245, 27356, 27466, 27575, 27683, 27790, 27896, 28001,
+	28105, 28208, 28310, 28411, 28510, 28609, 28706, 28803,
+	28898, 28992, 29085, 29177, 29268, 29358, 29447, 29534,
+	29621, 29706, 29791, 29874, 29956, 30037, 30117, 30195,
+	30273, 30349, 30424, 30498, 30571, 30643, 30714, 30783,
+	30852, 30919, 30985, 31050, 31113, 31176, 31237, 31297,
+	31356, 31414, 31470, 31526, 31580, 31633, 31685, 31736,
+	31785, 31833, 31880, 31926, 31971, 32014, 32057, 32098,
+	32137, 32176, 32213, 32250, 32285, 32318, 32351, 32382,
+	32412, 32441, 32469, 32495, 32521, 32545, 32567, 32589,
+	32609, 32628, 32646, 32663, 32678, 32692, 32705, 32717,
+	32728, 32737, 32745, 32752, 32757, 32761, 32765, 32766,
+	32767
+};
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+//Sine of a 16-bit angle, linear interpolation between table entries. Error
+//is below 1 LSB.
+int16_t sin_q15(uint16_t ang)
+{
+	uint16_t quad = ang >> 14;
+	uint16_t pos = ang & (ANG16_QUARTER - 1);
+	uint16_t idx = 0, frac = 0;
+	int32_t val = 0;
+
+	//2nd & 4th quadrants are mirrored:
+	if(quad & 1)
+	{
+		pos = ANG16_QUARTER - pos;
+	}
+
+	idx = pos >> (14 - SIN_Q15_TABLE_BITS);
+	frac = pos & ((1 << (14 - SIN_Q15_TABLE_BITS)) - 1);
+	val = sinQ15Table[idx];
+	if(frac)
+	{
+		val += ((sinQ15Table[idx + 1] - val) * frac + (1 << (13 - SIN_Q15_TABLE_BITS))) \
+				>> (14 - SIN_Q15_TABLE_BITS);
+	}
+
+	//3rd & 4th are negative:
+	return (quad & 2) ? (int16_t)(-val) : (int16_t)val;
+}
+
+int16_t cos_q15(uint16_t ang)
+{
+	return sin_q15((uint16_t)(ang + ANG16_QUARTER));
+}
+
+//t/period, as a 16-bit angle (rounded, wraps every period)
+uint16_t ratio_to_ang16(int32_t t, int32_t period)
+{
+	if(period <= 0)
+	{
+		return 0;
+	}
+
+	t %= period;
+	if(t < 0)
+	{
+		t += period;
+	}
+
+	if(period <= 0xFFFF)
+	{
+		//Fits in 32 bits, single UDIV:
+		return (uint16_t)((((uint32_t)t << 16) + ((uint32_t)period >> 1)) / (uint32_t)period);
+	}
+
+	return (uint16_t)((((uint64_t)t << 16) + ((uint64_t)period >> 1)) / (uint64_t)period);
+}
+
+//Integer square root, rounded down. 16 iterations, no division.
+uint16_t sqrt_u32(uint32_t x)
+{
+	uint32_t res = 0, bit = (uint32_t)1 << 30;
+
+	while(bit > x)
+	{
+		bit >>= 2;
+	}
+
+	while(bit)
+	{
+		if(x >= res + bit)
+		{
+			x -= res + bit;
+			res = (res >> 1) + bit;
+		}
+		else
+		{
+			res >>= 1;
+		}
+		bit >>= 2;
+	}
+
+	return (uint16_t)res;
+}
+
+//****************************************************************************
+// Test Function(s) - Use with care!
+//****************************************************************************
+
+//Compares sin_q15() to the libm version over a full turn. Uses doubles, keep
+//it out of the normal code. Read 'maxErr' with the debugger (expected: 1).
+void fixed_math_sin_test_code_blocking(void)
+{
+	uint32_t ang = 0;
+	int32_t ref = 0, err = 0;
+	volatile int32_t maxErr = 0;
+
+	for(ang = 0; ang < ANG16_TURN; ang++)
+	{
+		ref = (int32_t)round(Q15_ONE * sin((double)ang * 6.283185307179586 / ANG16_TURN));
+		err = sin_q15((uint16_t)ang) - ref;
+		if(err < 0) {err = -err;}
+		if(err > maxErr) {maxErr = err;}
+	}
+
+	while(1)
+	{
+		//Result in 'maxErr'
+	}
+}
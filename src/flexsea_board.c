@@ -89,7 +89,8 @@ void flexsea_send_serial_master(PacketWrapper* p)
 	{
 		#ifdef USE_USB
 			
-			usb_puts(str, length);
+			//Only the packed bytes:
+			usb_puts(str, (p->numb) ? p->numb : length);
 			
 		#endif
 	}
@@ -120,6 +121,8 @@ void flexsea_receive_from_master(void)
 
 	#ifdef USE_RS485
 		
+		//Short commands, before the DMA buffer is full:
+		rs485_rx_poll();
 		//tryUnpacking(&commPeriph[PORT_RS485_1], &packet[PORT_RS485_1][INBOUND]);
 		commPeriph[PORT_RS485_1].rx.unpackedPacketsAvailable = tryParseRx(&commPeriph[PORT_RS485_1], &packet[PORT_RS485_1][INBOUND]);
 		
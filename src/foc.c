@@ -0,0 +1,229 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-execute' Advanced Motion Controller
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] foc: Field Oriented Control current loop (sine commutation)
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-17 | agent | Initial release
+	*
+****************************************************************************/
+
+//Axes: q is aligned with the sin() commutation profile (phase A voltage =
+//q*sin(e) + d*cos(e)), d with the cos() term. Phase B = A + 120deg, C = A +
+//240deg, like commElecAng[]. All the math is done in the motor frame, the
+//user values go through MOTOR_ORIENTATION like setMotorVoltage().
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include "main.h"
+#include "foc.h"
+#include "fixed_math.h"
+#include "sensor_commut.h"
+#include "current_sensing.h"
+#include "control.h"
+#include "motor.h"
+#include "safety.h"
+#include "main_fsm.h"
+#include "mag_encoders.h"
+#include "user-ex.h"
+#include "motor_id.h"
+#include "flexsea_global_structs.h"
+
+//****************************************************************************
+// Variable(s)
+//****************************************************************************
+
+struct foc_s foc;
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static int32_t foc_pi(int32_t err, int32_t *errSum, uint8_t ch);
+static uint8_t foc_limit(int32_t *d, int32_t *q, int32_t max);
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+//Call from the 10kHz FSM. Setpoints in motor_current_pid_3() units.
+void foc_set_current(int32_t iq, int32_t id)
+{
+	int32_t vb = 0;
+	uint8_t inRange = 0;
+
+	vb = getDrooplessBatteryVoltage(&inRange);
+
+	foc.iqRef = MOTOR_ORIENTATION * iq;
+	foc.idRef = MOTOR_ORIENTATION * id;
+	foc.pwmPerMv = (inRange) ? ((577 << 16) / vb) : 0;
+	foc.enabled = 1;
+}
+
+void foc_disable(void)
+{
+	foc.enabled = 0;
+	foc.dErrSum = 0;
+	foc.qErrSum = 0;
+	foc.vd = 0;
+	foc.vq = 0;
+}
+
+//Runs in the SPI ISR, after the encoder read. 'angSample' is the angle when
+//the currents were sampled, 'angOutput' the one when the PWM will be applied
+//(both 0-2047, like sensor_sin_commut()).
+void foc_current_loop(uint16_t angSample, uint16_t angOutput)
+{
+	int32_t ia = 0, ib = 0, ic = 0, ff = 0;
+	int32_t dErrSum = 0, qErrSum = 0;
+	uint8_t sat = 0;
+	uint16_t pwm[3] = {PWM_AMP, PWM_AMP, PWM_AMP};
+
+	if(findingpoles)
+	{
+		return;
+	}
+
+	//Phase currents, A = [1], B = [2], C = [0] (same as update_current_arrays())
+	ia = -FOC_MA_PER_LSB * (adc_dma_array[1] - phase_a_zero);
+	ib = -FOC_MA_PER_LSB * (adc_dma_array[2] - phase_b_zero);
+	ic = -FOC_MA_PER_LSB * (adc_dma_array[0] - phase_c_zero);
+
+	foc_clarke_park(ia, ib, ic, commElecAng[angSample], &foc.id, &foc.iq);
+
+	if(criticalError(0) || suppressMotor || badFindPoles || !foc.pwmPerMv)
+	{
+		//All PWM to 0 - Maximum damping
+		foc.dErrSum = 0;
+		foc.qErrSum = 0;
+		setDmaPwmCompare(PWM_AMP, PWM_AMP, PWM_AMP);
+		return;
+	}
+
+	//Feed-forward (back-EMF & resistance), in the user frame:
+	ff = (as5047.signed_ang_vel * motorId.bemfFF + MOTOR_ORIENTATION * foc.iqRef * motorId.rFF) >> MOTOR_ID_FF_SHIFT;
+
+	dErrSum = foc.dErrSum;
+	qErrSum = foc.qErrSum;
+	foc.vd = foc_pi(foc.idRef - foc.id, &foc.dErrSum, 0);
+	foc.vq = foc_pi(foc.iqRef - foc.iq, &foc.qErrSum, 0) + MOTOR_ORIENTATION * ff;
+
+	//mV to PWM units, then voltage vector limit:
+	foc.pwmD = (foc.vd * foc.pwmPerMv) >> 16;
+	foc.pwmQ = (foc.vq * foc.pwmPerMv) >> 16;
+	sat = foc_limit(&foc.pwmD, &foc.pwmQ, (pwmModulation == MOD_SINE) ? FOC_PWM_MAX_SINE : FOC_PWM_MAX_SVPWM);
+
+	//Anti-windup: a clipped axis keeps the integral it had before this cycle,
+	//unless the error is pulling it out of saturation
+	if((sat & FOC_SAT_D) && ((foc.idRef - foc.id) ^ foc.pwmD) >= 0) {foc.dErrSum = dErrSum;}
+	if((sat & FOC_SAT_Q) && ((foc.iqRef - foc.iq) ^ foc.pwmQ) >= 0) {foc.qErrSum = qErrSum;}
+
+	foc_inv_park_pwm(foc.pwmD, foc.pwmQ, commElecAng[angOutput], pwm);
+	setDmaPwmCompare(pwm[0], pwm[1], pwm[2]);
+}
+
+//Phase currents to d/q. Scaled by 3/2 (not amplitude-invariant) to match the
+//units of update_current_arrays().
+void foc_clarke_park(int32_t ia, int32_t ib, int32_t ic, uint16_t elecAng, \
+						int32_t *d, int32_t *q)
+{
+	int32_t alpha = 0, beta = 0, s = 0, c = 0;
+
+	//Clarke:
+	alpha = (2 * ia - ib - ic) >> 1;
+	beta = ((ib - ic) * Q15_SQRT3_2) >> 15;
+
+	//Park:
+	s = sin_q15(elecAng);
+	c = cos_q15(elecAng);
+	*q = ((alpha * s) >> 15) + ((beta * c) >> 15);
+	*d = ((alpha * c) >> 15) - ((beta * s) >> 15);
+}
+
+//d/q voltages (1024 = PWM_AMP) to PWM compare values, with the modulation
+//selected by pwmModulation (sensor_commut)
+void foc_inv_park_pwm(int32_t d, int32_t q, uint16_t elecAng, uint16_t *pwm)
+{
+	int32_t alpha = 0, beta = 0, s = 0, c = 0, m = 0;
+	int32_t v[3];
+	uint8_t i = 0;
+
+	//Inverse Park:
+	s = sin_q15(elecAng);
+	c = cos_q15(elecAng);
+	alpha = ((q * s) >> 15) + ((d * c) >> 15);
+	beta = ((q * c) >> 15) - ((d * s) >> 15);
+
+	//Inverse Clarke, in PWM counts:
+	v[0] = (alpha * PWM_AMP) >> 10;
+	v[1] = ((-(alpha >> 1) + ((beta * Q15_SQRT3_2) >> 15)) * PWM_AMP) >> 10;
+	v[2] = ((-(alpha >> 1) - ((beta * Q15_SQRT3_2) >> 15)) * PWM_AMP) >> 10;
+
+	m = (sqrt_u32((uint32_t)(d * d + q * q)) * PWM_AMP) >> 10;
+	pwm_modulate(v, m * m);
+
+	for(i = 0; i < 3; i++)
+	{
+		v[i] += PWM_AMP;
+		if(v[i] > 989) {v[i] = 989;}
+		else if(v[i] < 1) {v[i] = 1;}
+		pwm[i] = (uint16_t)v[i];
+	}
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+//PI with the current controller gains. The integral is frozen while the
+//output is saturated (restored by foc_current_loop(), see foc_limit()).
+static int32_t foc_pi(int32_t err, int32_t *errSum, uint8_t ch)
+{
+	int32_t sum = *errSum + err;
+
+	if(sum > FOC_MAX_ERR_SUM) {sum = FOC_MAX_ERR_SUM;}
+	else if(sum < -FOC_MAX_ERR_SUM) {sum = -FOC_MAX_ERR_SUM;}
+	*errSum = sum;
+
+	return ((ctrl[ch].current.gain.I_KP * err) >> FOC_KP_SHIFT) + \
+			((ctrl[ch].current.gain.I_KI * sum) >> FOC_KI_SHIFT);
+}
+
+//Limits |(d,q)| to 'max', d has priority. Returns the clipped axes
+//(FOC_SAT_D, FOC_SAT_Q).
+static uint8_t foc_limit(int32_t *d, int32_t *q, int32_t max)
+{
+	int32_t qMax = 0;
+	uint8_t sat = 0;
+
+	if(*d > max) {*d = max; sat |= FOC_SAT_D;}
+	else if(*d < -max) {*d = -max; sat |= FOC_SAT_D;}
+
+	qMax = sqrt_u32((uint32_t)(max * max - (*d) * (*d)));
+	if(*q > qMax) {*q = qMax; sat |= FOC_SAT_Q;}
+	else if(*q < -qMax) {*q = -qMax; sat |= FOC_SAT_Q;}
+
+	return sat;
+}
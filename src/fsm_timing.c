@@ -0,0 +1,261 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-execute' Advanced Motion Controller
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] fsm_timing: execution time statistics for the main FSM slots
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-17 | agent | Initial release
+	*
+****************************************************************************/
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include "main.h"
+#include "fsm_timing.h"
+#include "misc.h"
+#include "motor.h"
+#include <string.h>
+#include <flexsea.h>
+#include <flexsea_payload.h>
+#include "flexsea_sys_def.h"
+
+//****************************************************************************
+// Variable(s)
+//****************************************************************************
+
+struct fsm_timing_s fsmTiming[FSM_TIMING_SLOTS];
+volatile struct sample_stamp_s sampleStamp;
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static uint8_t fsmTimingBin(uint32_t cycles);
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+//Starts the cycle counter and registers the read command
+void initFsmTiming(void)
+{
+	#ifndef SIM_HOST
+	DEMCR_REG |= DEMCR_TRCENA;
+	DWT_CYCCNT_REG = 0;
+	DWT_CTRL_REG |= DWT_CTRL_CYCCNTENA;
+	#endif	//SIM_HOST
+
+	fsmTimingReset();
+
+	flexsea_multipayload_ptr[CMD_FSM_TIMING][RX_PTYPE_READ] = &rx_multi_cmd_fsm_timing_rr;
+}
+
+void fsmTimingReset(void)
+{
+	uint8_t i = 0;
+
+	memset(fsmTiming, 0, sizeof(fsmTiming));
+	for(i = 0; i < FSM_TIMING_SLOTS; i++)
+	{
+		fsmTiming[i].min = UINT32_MAX;
+	}
+	for(i = 0; i < 10; i++)
+	{
+		timingError[i] = 0;
+	}
+}
+
+//Call with the execution time of one slot. Keep it short, it runs at 10kHz.
+void fsmTimingStore(uint8_t slot, uint32_t cycles)
+{
+	struct fsm_timing_s *t = &fsmTiming[slot];
+	uint8_t bin = fsmTimingBin(cycles);
+
+	if(cycles < t->min) {t->min = cycles;}
+	if(cycles > t->max) {t->max = cycles;}
+	t->sum += cycles;
+
+	//p99: up 99 steps when above, down 1 step when below. Settles where 1% of
+	//the samples are above the estimate.
+	if(t->count == 0)
+	{
+		t->p99 = cycles;
+	}
+	else if(cycles > t->p99)
+	{
+		t->p99 += 99 * FSM_TIMING_P99_STEP;
+		if(t->p99 > t->max) {t->p99 = t->max;}
+	}
+	else if(t->p99 >= FSM_TIMING_P99_STEP)
+	{
+		t->p99 -= FSM_TIMING_P99_STEP;
+	}
+
+	if(t->count < UINT32_MAX) {t->count++;}
+	if(t->hist[bin] < UINT16_MAX) {t->hist[bin]++;}
+}
+
+//ISR execution time, with a fixed budget
+void fsmTimingStoreIsr(uint32_t cycles)
+{
+	fsmTimingStore(FSM_TIMING_ISR, cycles);
+	if((cycles > FSM_TIMING_ISR_BUDGET) && (fsmTiming[FSM_TIMING_ISR].overruns < UINT16_MAX))
+	{
+		fsmTiming[FSM_TIMING_ISR].overruns++;
+	}
+}
+
+//Call after mainFSM10kHz(): if the next 100us tick is already there, 'slot'
+//plus the 10kHz code took too long.
+void fsmTimingCheckOverrun(uint8_t slot)
+{
+	if(t1_new_value)
+	{
+		if(fsmTiming[slot].overruns < UINT16_MAX) {fsmTiming[slot].overruns++;}
+		if(timingError[slot] < INT8_MAX) {timingError[slot]++;}
+	}
+}
+
+uint32_t fsmTimingMean(uint8_t slot)
+{
+	if(fsmTiming[slot].count == 0)
+	{
+		return 0;
+	}
+
+	return (uint32_t)(fsmTiming[slot].sum / fsmTiming[slot].count);
+}
+
+//Free-running timestamp, us (wraps every 71 minutes). Built on the cycle
+//counter, call it at least every 50s (wraps at 53s at 80MHz).
+uint32_t fsmTimingNowUs(void)
+{
+	#ifdef SIM_HOST
+	
+	return simHalTimeUs();
+	
+	#else
+	
+	static uint32_t lastCycles = 0, us = 0;
+	uint32_t elapsed = 0, t = 0;
+	uint8 intState = 0;
+	
+	intState = CyEnterCriticalSection();
+	elapsed = (DWT_CYCCNT_REG - lastCycles) / (BCLK__BUS_CLK__HZ / 1000000u);
+	lastCycles += elapsed * (BCLK__BUS_CLK__HZ / 1000000u);
+	us += elapsed;
+	t = us;
+	CyExitCriticalSection(intState);
+	
+	return t;
+	
+	#endif	//SIM_HOST
+}
+
+//CPU time used by a slot, per mil, from its mean execution time and its
+//rate: 1kHz (mainFSM0-9), 10kHz or PWM_FREQ_HZ (ISR)
+uint16_t fsmTimingCpuLoad(uint8_t slot)
+{
+	uint32_t hz = 1000;
+
+	if(slot == FSM_TIMING_10KHZ) {hz = 10000;}
+	else if(slot == FSM_TIMING_ISR) {hz = PWM_FREQ_HZ;}
+
+	return (uint16_t)(((uint64_t)fsmTimingMean(slot) * hz * 1000) / BCLK__BUS_CLK__HZ);
+}
+
+//All the slots. The headroom is 1000 minus this value.
+uint16_t fsmTimingCpuLoadTotal(void)
+{
+	uint16_t load = 0;
+	uint8_t i = 0;
+
+	for(i = 0; i < FSM_TIMING_SLOTS; i++)
+	{
+		load += fsmTimingCpuLoad(i);
+	}
+
+	return load;
+}
+
+//Reply: slot, count, min, max, mean, p99 (uint32), overruns, hist[] (uint16)
+void rx_multi_cmd_fsm_timing_rr(uint8_t *msgBuf, MultiPacketInfo *info, \
+								uint8_t *responseBuf, uint16_t* responseLen)
+{
+	static uint8_t nextSlot = 0;
+	uint8_t slot = 0, i = 0;
+	uint16_t index = 0;
+	struct fsm_timing_s *t;
+	(void)info;
+
+	if((msgBuf[0] & ~FSM_TIMING_REQ_RESET) == 0)
+	{
+		//Streaming: one slot per call
+		slot = nextSlot;
+		TICK_COUNTER(nextSlot, FSM_TIMING_SLOTS);
+	}
+	else
+	{
+		slot = (msgBuf[0] & ~FSM_TIMING_REQ_RESET) - 1;
+		if(slot >= FSM_TIMING_SLOTS) {slot = FSM_TIMING_10KHZ;}
+	}
+	t = &fsmTiming[slot];
+
+	responseBuf[index++] = slot;
+	SPLIT_32(t->count, responseBuf, &index);
+	SPLIT_32((t->count) ? t->min : 0, responseBuf, &index);
+	SPLIT_32(t->max, responseBuf, &index);
+	SPLIT_32(fsmTimingMean(slot), responseBuf, &index);
+	SPLIT_32(t->p99, responseBuf, &index);
+	SPLIT_16(t->overruns, responseBuf, &index);
+	for(i = 0; i < FSM_TIMING_BINS; i++)
+	{
+		SPLIT_16(t->hist[i], responseBuf, &index);
+	}
+
+	*responseLen = index;
+
+	if(msgBuf[0] & FSM_TIMING_REQ_RESET)
+	{
+		fsmTimingReset();
+	}
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+//Bin n holds [2^n, 2^(n+1)) cycles (bin 0 also has 0)
+static uint8_t fsmTimingBin(uint32_t cycles)
+{
+	uint8_t bin = 0;
+
+	if(cycles > 1)
+	{
+		bin = 31 - __builtin_clz(cycles);
+	}
+
+	return (bin < FSM_TIMING_BINS) ? bin : (FSM_TIMING_BINS - 1);
+}
@@ -39,101 +39,90 @@
 #include "ext_input.h"
 #include "user-ex.h"
 #include "mag_encoders.h"
+#include "ui.h"
 #include "flexsea_global_structs.h"
+#include <string.h>
 
 //****************************************************************************
 // Variable(s)
 //****************************************************************************
 
-uint8_t i2c_last_request = 0;
-volatile uint8_t i2c_0_r_buf[24];
+struct i2c_queue_s i2c0q;
 
 //****************************************************************************
 // Private Function Prototype(s):
 //****************************************************************************
 
+static void i2c0_start_next(void);
+static void i2c0_kick(void);
 
 //****************************************************************************
 // Public Function(s)
 //****************************************************************************
 
+//Call at 1kHz: schedules the periodic reads, then starts the queue if the bus
+//is idle. The ISR does the rest.
 void i2c_0_fsm(void)
 {
-	static uint8_t i2c_time_share = 0;
-	static uint8_t minm_i2c = 0;
+	#ifdef USE_I2C_0
 	
-	i2c_time_share++;
-	i2c_time_share %= 4;
-
-	#ifdef USE_I2C_0 
-
-	//Subdivided in 4 slots (250Hz)
-	switch(i2c_time_share)
+	uint8_t i = 0;
+	struct i2c_xfer_s *t;
+	
+	//I2C RGB LED (one-shot write when the color changes):
+	#ifdef USE_MINM_RGB
+	update_minm_rgb();
+	#endif 	//USE_MINM_RGB
+	
+	for(i = 0; i < i2c0q.taskCnt; i++)
 	{
-		//Case 0.0: Accelerometer
-		case 0:
-		
-			#ifdef USE_IMU
-			get_accel_xyz();
-			i2c_last_request = I2C_RQ_ACCEL;
-			#endif 	//USE_IMU
-		
-			break;
-		
-		//Case 0.1: Gyroscope
-		case 1:
-			
-			#ifdef USE_IMU
-			get_gyro_xyz();
-			i2c_last_request = I2C_RQ_GYRO;
-			#endif 	//USE_IMU
-			
-			break;
-		
-		//Case 0.2: AS5048B position sensor
-		case 2:
-			#ifdef USE_AS5048B
-			get_as5048b_position();
-			i2c_last_request = I2C_RQ_AS5048B;
-			
-			#endif //USE_AS5048B
-			break;
-		
-		//Case 0.3: MinM RGB LED & external strain amplifier
-		case 3:
-			
-			//I2C RGB LED
-			#ifdef USE_MINM_RGB
-			//minm_test_code();	
-			minm_i2c = update_minm_rgb();
-			#else
-			minm_i2c = 0;	
-			#endif 	//USE_MINM_RGB
-			
-			//External strain gauge amplifier
-			#ifdef USE_EXT_I2C_STRAIN
-			if(!minm_i2c)
+		t = &i2c0q.task[i];
+		if(t->period && (--t->countdown == 0))
+		{
+			t->countdown = t->period;
+			if(t->pending)
 			{
-				//If the MinM was refreshed we skip one measurement.
-				get_6ch_strain();
-				i2c_last_request = I2C_RQ_EXT_STRAIN;
+				//Last one isn't done, skip this period:
+				if(i2c0q.overruns < UINT16_MAX) {i2c0q.overruns++;}
 			}
-			#endif //USE_EXT_I2C_STRAIN
-			
-			break;
-		
-		default:
-			break;
+			else
+			{
+				t->pending = 1;
+			}
+		}
 	}
 	
+	i2c0_kick();
+	
 	#endif //USE_I2C_0
 }
 
-//I2C0 - 3V3, IMU & Expansion.
+//I2C0 - 3V3, IMU & Expansion. Registers the periodic reads.
 void init_i2c_0(void)
 {
+	memset(&i2c0q, 0, sizeof(i2c0q));
+	
 	I2C_0_EnableInt();
-	I2C_0_Start();	
+	I2C_0_Start();
+	
+	//Fastest first, it has the priority:
+	#ifdef USE_AS5048B
+	i2c0_register(I2C_ADDR_AS5048B, AD5048B_REG_ANGLE_H, 2, I2C0_PERIOD_AS5048B, &as5048b_decode);
+	#endif //USE_AS5048B
+	
+	#ifdef USE_IMU
+	#ifdef USE_IMU_FIFO
+	//Count every period, then a batch from the FIFO:
+	imuFifo.readTask = i2c0_register(IMU_ADDR, IMU_FIFO_R_W, IMU_BURST_LEN, 0, &imu_fifo_data_decode);
+	i2c0_register(IMU_ADDR, IMU_FIFO_COUNT_H, 2, I2C0_PERIOD_IMU, &imu_fifo_count_decode);
+	#else
+	i2c0_register(IMU_ADDR, IMU_ACCEL_XOUT_H, IMU_BURST_LEN, I2C0_PERIOD_IMU, &imu_burst_decode);
+	#endif	//USE_IMU_FIFO
+	#endif 	//USE_IMU
+	
+	#ifdef USE_EXT_I2C_STRAIN
+	i2c0_register(I2C_SLAVE_ADDR_6CH, MEM_R_CH1_H, 9, I2C0_PERIOD_EXT_STRAIN, &strain_6ch_decode);
+	#endif //USE_EXT_I2C_STRAIN
 }
 
 //I2C1 - 5V, Safety-CoP & strain gauge pot
@@ -143,46 +132,177 @@ void init_i2c_1(void)
 	I2C_1_Start();
 }
 
-//Manual I2C [Write - Restart - Read n bytes] function
-//Takes around xus (400kHz) to run, then the ISR takes care of everything.
-int i2c0_read(uint8_t slave_addr, uint8_t reg_addr, uint8_t *pdata, uint16 length)
+//Periodic read of 'len' bytes from 'reg', every 'period' i2c_0_fsm() ticks
+//(0: only when triggered). 'done' gets the data, from the ISR. Returns the
+//task number, -1 if full.
+int8_t i2c0_register(uint8_t addr, uint8_t reg, uint8_t len, uint8_t period, \
+						void (*done)(uint8_t *buf))
 {
-	uint8_t status = 0, i = 0;
+	struct i2c_xfer_s *t;
 	
-	//Currently having trouble detecting the flags to know when data is ready.
-	//For now I'll transfer the previous buffer.
-	for(i = 0; i < length; i++)
+	if((i2c0q.taskCnt >= I2C0_MAX_TASKS) || (len > I2C0_BUF_LEN))
 	{
-		pdata[i] = i2c_0_r_buf[i];
+		return -1;
 	}
 	
-	//Store data:
-	assign_i2c_data(i2c_0_r_buf);
+	t = &i2c0q.task[i2c0q.taskCnt];
+	t->type = I2C_XFER_READ;
+	t->addr = addr;
+	t->reg = reg;
+	t->len = len;
+	t->period = period;
+	t->countdown = (period) ? ((i2c0q.taskCnt % period) + 1) : 0;	//Spread them
+	t->pending = 0;
+	t->done = done;
 	
-	//Clear status:
-	//I2C_0_MasterClearStatus();
+	return (int8_t)i2c0q.taskCnt++;
+}
+
+//Queues an on-demand read of 'len' bytes. Can be called from a decoder, the
+//read then follows the current transfer. Returns 1 if it's already pending.
+uint8_t i2c0_trigger(int8_t task, uint8_t len)
+{
+	struct i2c_xfer_s *t;
 	
-	//Start, address, Write mode
-	status = I2C_0_MasterSendStart(slave_addr, 0);
-	if(status != I2C_0_MSTR_NO_ERROR)
+	if((task < 0) || (task >= i2c0q.taskCnt) || (len > I2C0_BUF_LEN))
+	{
 		return 1;
+	}
 	
-	//Write to register
-	status = I2C_0_MasterWriteByteTimeOut(reg_addr, 500);
-	if(status != I2C_0_MSTR_NO_ERROR)
+	t = &i2c0q.task[task];
+	if(t->pending)
 	{
-		//Release bus:
-		I2C_0_BUS_RELEASE;
-		
-		return 2;
+		return 1;
 	}
+	
+	t->len = len;
+	t->pending = 1;
+	
+	i2c0_kick();
+	
+	return 0;
+}
 
-	//Repeat start, read then stop (all by ISR):
-	I2C_0_MasterReadBuf(slave_addr, (uint8_t *)i2c_0_r_buf, length, (I2C_0_MODE_COMPLETE_XFER | I2C_0_MODE_REPEAT_START));
+//Queues a write (first byte: register address). Non-blocking, returns 1 if
+//the previous one-shot transfer isn't done.
+uint8_t i2c0_write(uint8_t slave_addr, uint8_t *pdata, uint8_t length)
+{
+	struct i2c_xfer_s *t = &i2c0q.oneShot;
+	
+	if(t->pending || (length > I2C0_BUF_LEN))
+	{
+		return 1;
+	}
+	
+	t->type = I2C_XFER_WRITE;
+	t->addr = slave_addr;
+	t->len = length;
+	memcpy(t->buf, pdata, length);
+	t->done = NULL;
+	t->retries = 0;
+	t->pending = 1;
+	
+	i2c0_kick();
 	
 	return 0;
 }
 
+//Blocking [Write - Restart - Read n bytes], for the test code. The periodic
+//reads don't need it.
+int i2c0_read(uint8_t slave_addr, uint8_t reg_addr, uint8_t *pdata, uint16 length)
+{
+	struct i2c_xfer_s *t = &i2c0q.oneShot;
+	uint16_t errors = 0;
+	uint32_t us = 0;
+	
+	if(t->pending || (length > I2C0_BUF_LEN))
+	{
+		return I2C0_READ_BUSY;
+	}
+	
+	errors = t->errors;
+	t->type = I2C_XFER_READ;
+	t->addr = slave_addr;
+	t->reg = reg_addr;
+	t->len = (uint8_t)length;
+	t->done = NULL;
+	t->retries = 0;
+	t->pending = 1;
+	
+	i2c0_kick();
+	
+	while(t->pending)
+	{
+		if(++us > I2C0_TIMEOUT_US(length))
+		{
+			return I2C0_READ_TIMEOUT;
+		}
+		
+		//i2c_0_fsm() can't retry a failed start while we wait here:
+		if((us % I2C0_RETRY_US) == 0) {i2c0_kick();}
+		CyDelayUs(1);
+	}
+	
+	if(t->errors != errors)
+	{
+		return I2C0_READ_ERROR;
+	}
+	
+	memcpy(pdata, t->buf, length);
+	
+	return I2C0_READ_OK;
+}
+
+//Call from I2C_0_ISR_ExitCallback(), at the end of every I2C0 interrupt.
+//Chains the transfers: register address, read, decoder, next one.
+void i2c0_isr(void)
+{
+	struct i2c_xfer_s *t = i2c0q.current;
+	uint8_t status = 0;
+	
+	if(i2c0q.state == I2C_Q_IDLE)
+	{
+		return;
+	}
+	
+	status = I2C_0_MasterStatus();
+	
+	if(status & I2C_0_MSTAT_ERR_XFER)
+	{
+		I2C_0_MasterClearStatus();
+		I2C_0_BUS_RELEASE;
+		if(t->errors < UINT16_MAX) {t->errors++;}
+		if(i2c0q.errors < UINT16_MAX) {i2c0q.errors++;}
+	}
+	else if((i2c0q.state == I2C_Q_REG) && (status & I2C_0_MSTAT_WR_CMPLT))
+	{
+		//Register address sent, repeat start & read:
+		I2C_0_MasterClearStatus();
+		i2c0q.state = I2C_Q_READ;
+		I2C_0_MasterReadBuf(t->addr, t->buf, t->len, (I2C_0_MODE_COMPLETE_XFER | I2C_0_MODE_REPEAT_START));
+		return;
+	}
+	else if((i2c0q.state == I2C_Q_READ) && (status & I2C_0_MSTAT_RD_CMPLT))
+	{
+		I2C_0_MasterClearStatus();
+		if(t->done) {t->done(t->buf);}
+		i2c0q.transfers++;
+	}
+	else if((i2c0q.state == I2C_Q_WRITE) && (status & I2C_0_MSTAT_WR_CMPLT))
+	{
+		I2C_0_MasterClearStatus();
+		i2c0q.transfers++;
+	}
+	else
+	{
+		//Still going
+		return;
+	}
+	
+	t->pending = 0;
+	i2c0_start_next();
+}
+
 //Simplified version of I2C_0_MasterWriteByte() (single master only) with timeouts
 //timeout is in us
 uint8_t I2C_0_MasterWriteByteTimeOut(uint8_t theByte, uint32 timeout)
@@ -245,53 +365,77 @@ uint8_t I2C_0_MasterWriteByteTimeOut(uint8_t theByte, uint32 timeout)
 	return(errStatus);
 }
 
-//Associate data with the right structure. We need that because of the way the ISR-based
-//I2C works (we always get data from the last request)
-void assign_i2c_data(uint8_t *newdata)
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+//Starts the first pending transfer (one-shot, then the tasks in registration
+//order). Call with the queue idle, from the ISR or a critical section.
+static void i2c0_start_next(void)
 {
-	uint16 tmp = 0;
+	struct i2c_xfer_s *t = NULL;
+	uint8_t i = 0, status = 0;
 	
-	if(i2c_last_request == I2C_RQ_GYRO)
+	if(i2c0q.oneShot.pending)
 	{
-		//Gyro X:
-		tmp = ((uint16)newdata[0] << 8) | ((uint16) newdata[1]);
-		imu.gyro.x = (int16)tmp;
-		
-		//Gyro Y:
-		tmp = ((uint16)newdata[2] << 8) | ((uint16) newdata[3]);
-		imu.gyro.y = (int16)tmp;
-		
-		//Gyro Z:
-		tmp = ((uint16)newdata[4] << 8) | ((uint16) newdata[5]);
-		imu.gyro.z = (int16)tmp;		
+		t = &i2c0q.oneShot;
 	}
-	else if(i2c_last_request == I2C_RQ_ACCEL)
+	else
 	{
-		//Accel X:
-		tmp = ((uint16)newdata[0] << 8) | ((uint16) newdata[1]);
-		imu.accel.x = (int16)tmp;
-		
-		//Accel Y:
-		tmp = ((uint16)newdata[2] << 8) | ((uint16) newdata[3]);
-		imu.accel.y = (int16)tmp;
-		
-		//Accel Z:
-		tmp = ((uint16)newdata[4] << 8) | ((uint16) newdata[5]);
-		imu.accel.z = (int16)tmp;		
+		for(i = 0; i < i2c0q.taskCnt; i++)
+		{
+			if(i2c0q.task[i].pending)
+			{
+				t = &i2c0q.task[i];
+				break;
+			}
+		}
 	}
-	else if(i2c_last_request == I2C_RQ_AS5048B)
+	
+	i2c0q.current = t;
+	if(t == NULL)
 	{
-		reset_ang_counter(&as5048b);
-		tmp = (newdata[0]<<6) + (newdata[1]&0x3F);
-		update_as504x(tmp, &as5048b);	 
+		i2c0q.state = I2C_Q_IDLE;
+		return;
 	}
-	else if(i2c_last_request == I2C_RQ_EXT_STRAIN)
+	
+	I2C_0_MasterClearStatus();
+	if(t->type == I2C_XFER_WRITE)
 	{
-		//strain_6ch_bytes_to_words(newdata);
-		int i = 0;
-		for(i = 0; i < 9; i++)
+		i2c0q.state = I2C_Q_WRITE;
+		status = I2C_0_MasterWriteBuf(t->addr, t->buf, t->len, I2C_0_MODE_COMPLETE_XFER);
+	}
+	else
+	{
+		i2c0q.state = I2C_Q_REG;
+		status = I2C_0_MasterWriteBuf(t->addr, &t->reg, 1, I2C_0_MODE_NO_STOP);
+	}
+	
+	if(status != I2C_0_MSTR_NO_ERROR)
+	{
+		//Bus not ready. Periodic reads are dropped, they will be retried at
+		//their next period. One-shots stay pending for the next kick, up to
+		//I2C0_START_RETRIES times (i2c0_read() then returns an error).
+		if(i2c0q.errors < UINT16_MAX) {i2c0q.errors++;}
+		if((t != &i2c0q.oneShot) || (++t->retries >= I2C0_START_RETRIES))
 		{
-			strain1.compressedBytes[i] = newdata[i];
+			if(t->errors < UINT16_MAX) {t->errors++;}
+			t->pending = 0;
 		}
-	}	
+		i2c0q.current = NULL;
+		i2c0q.state = I2C_Q_IDLE;
+	}
+}
+
+//Starts the queue if it's idle
+static void i2c0_kick(void)
+{
+	uint8 intState = 0;
+	
+	intState = CyEnterCriticalSection();
+	if(i2c0q.state == I2C_Q_IDLE)
+	{
+		i2c0_start_next();
+	}
+	CyExitCriticalSection(intState);
 }
@@ -35,6 +35,7 @@
 #include "main.h"
 #include "imu.h"
 #include "i2c.h"
+#include "fsm_timing.h"
 #include "flexsea_global_structs.h"
 
 //****************************************************************************
@@ -43,6 +44,8 @@
 
 volatile uint8_t i2c_tmp_buf[IMU_MAX_BUF_SIZE];
 struct imu_s imu;
+int16_t imuTemp = 0;
+struct imu_fifo_s imuFifo;
 
 //****************************************************************************
 // Private Function Prototype(s)
@@ -60,11 +63,31 @@ void init_imu(void)
 	CyDelay(25);
 	
 	//Initialize the config registers.
+	#ifndef USE_IMU_FIFO
 	uint8_t config[4] = { D_IMU_CONFIG, D_IMU_GYRO_CONFIG, D_IMU_ACCEL_CONFIG, \
 							D_IMU_ACCEL_CONFIG2 };
+	#else
+	uint8_t config[4] = { D_IMU_CONFIG_FIFO, D_IMU_GYRO_CONFIG, D_IMU_ACCEL_CONFIG, \
+							D_IMU_ACCEL_CONFIG2 };
+	#endif	//USE_IMU_FIFO
 	
 	//Send the config sequence
 	imu_write(IMU_CONFIG, config, 4);
+	
+	#ifdef USE_IMU_FIFO
+	
+	//1kHz samples in the FIFO:
+	config[0] = D_IMU_SMPLRT_DIV;
+	imu_write(IMU_SMPLRT_DIV, config, 1);
+	config[0] = D_IMU_FIFO_EN;
+	imu_write(IMU_FIFO_EN, config, 1);
+	config[0] = D_USER_CTRL_FIFO_EN | D_USER_CTRL_FIFO_RST;
+	imu_write(IMU_USER_CTRL, config, 1);
+	
+	imuFifo.head = 0;
+	imuFifo.tail = 0;
+	
+	#endif	//USE_IMU_FIFO
 }
 
 // Reset the IMU to default settings
@@ -97,13 +120,16 @@ int16_t get_accel_z(void)
 	return (int16_t)((uint16_t) data[0] << 8) | (data[1]);
 }
 
-//Puts all the accelerometer values in the structure:
+//Puts all the accelerometer values in the structure (blocking):
 void get_accel_xyz(void)
 {
-	uint8_t tmp_data[7] = {0,0,0,0,0,0};	
+	uint8_t tmp_data[6] = {0,0,0,0,0,0};	
 	
 	//According to the documentation it's X_H, X_L, Y_H, ...
-	i2c0_read(IMU_ADDR, IMU_ACCEL_XOUT_H, tmp_data, 7);	
+	if(i2c0_read(IMU_ADDR, IMU_ACCEL_XOUT_H, tmp_data, 6) == I2C0_READ_OK)
+	{
+		imu_accel_decode(tmp_data);
+	}
 }
 
 // Get gyro X
@@ -130,13 +156,125 @@ int16_t get_gyro_z(void)
 	return (int16_t)((uint16_t) data[0] << 8) | (data[1]);
 }
 
-//Puts all the gyroscope values in the structure:
+//Puts all the gyroscope values in the structure (blocking):
 void get_gyro_xyz(void)
 {
-	uint8_t tmp_data[7] = {0,0,0,0,0,0,0};
+	uint8_t tmp_data[6] = {0,0,0,0,0,0};
 	
 	//According to the documentation it's X_H, X_L, Y_H, ...
-	i2c0_read(IMU_ADDR, IMU_GYRO_XOUT_H, tmp_data, 6);
+	if(i2c0_read(IMU_ADDR, IMU_GYRO_XOUT_H, tmp_data, 6) == I2C0_READ_OK)
+	{
+		imu_gyro_decode(tmp_data);
+	}
+}
+
+//Accel, temperature & gyro in one read (blocking):
+void get_imu_burst(void)
+{
+	uint8_t tmp_data[IMU_BURST_LEN];
+	
+	if(i2c0_read(IMU_ADDR, IMU_ACCEL_XOUT_H, tmp_data, IMU_BURST_LEN) == I2C0_READ_OK)
+	{
+		imu_burst_decode(tmp_data);
+	}
+}
+
+//I2C0 queue decoders (6 bytes, X_H first), called from the ISR:
+void imu_accel_decode(uint8_t *buf)
+{
+	imu.accel.x = (int16)(((uint16)buf[0] << 8) | ((uint16)buf[1]));
+	imu.accel.y = (int16)(((uint16)buf[2] << 8) | ((uint16)buf[3]));
+	imu.accel.z = (int16)(((uint16)buf[4] << 8) | ((uint16)buf[5]));
+}
+
+void imu_gyro_decode(uint8_t *buf)
+{
+	imu.gyro.x = (int16)(((uint16)buf[0] << 8) | ((uint16)buf[1]));
+	imu.gyro.y = (int16)(((uint16)buf[2] << 8) | ((uint16)buf[3]));
+	imu.gyro.z = (int16)(((uint16)buf[4] << 8) | ((uint16)buf[5]));
+}
+
+//Burst read from IMU_ACCEL_XOUT_H: accel, temperature, gyro. All from the
+//same sample.
+void imu_burst_decode(uint8_t *buf)
+{
+	imu_accel_decode(&buf[0]);
+	imuTemp = (int16)(((uint16)buf[6] << 8) | ((uint16)buf[7]));
+	imu_gyro_decode(&buf[8]);
+}
+
+//FIFO mode, I2C0 queue decoder: byte count (FIFO_COUNT_H & L). Requests a
+//batch of up to IMU_FIFO_MAX_BATCH samples, the rest will be read next time.
+void imu_fifo_count_decode(uint8_t *buf)
+{
+	uint16_t count = (((uint16_t)buf[0] & 0x1F) << 8) | (uint16_t)buf[1];
+	uint8_t reset[2] = {IMU_USER_CTRL, D_USER_CTRL_FIFO_EN | D_USER_CTRL_FIFO_RST};
+	
+	//A full FIFO drops its oldest bytes, we can't find the sample boundaries:
+	if((count >= IMU_FIFO_SIZE - IMU_BURST_LEN) || (count % IMU_BURST_LEN))
+	{
+		if(!i2c0_write(IMU_ADDR, reset, 2))
+		{
+			if(imuFifo.resets < UINT16_MAX) {imuFifo.resets++;}
+		}
+		return;
+	}
+	
+	imuFifo.backlog = count / IMU_BURST_LEN;
+	if(imuFifo.backlog == 0)
+	{
+		return;
+	}
+	
+	imuFifo.countUs = fsmTimingNowUs();
+	imuFifo.batch = (imuFifo.backlog > IMU_FIFO_MAX_BATCH) ? IMU_FIFO_MAX_BATCH : imuFifo.backlog;
+	i2c0_trigger(imuFifo.readTask, imuFifo.batch * IMU_BURST_LEN);
+}
+
+//FIFO mode, I2C0 queue decoder: 'batch' samples, oldest first. The newest
+//sample in the FIFO was taken around countUs, the others 1ms apart.
+void imu_fifo_data_decode(uint8_t *buf)
+{
+	struct imu_sample_s *s;
+	uint8_t i = 0, next = 0;
+	
+	for(i = 0; i < imuFifo.batch; i++)
+	{
+		imu_burst_decode(&buf[i * IMU_BURST_LEN]);
+		imuFifo.samples++;
+		
+		next = (imuFifo.head + 1) & IMU_FIFO_QUEUE_MASK;
+		if(next == imuFifo.tail)
+		{
+			if(imuFifo.dropped < UINT16_MAX) {imuFifo.dropped++;}
+			continue;
+		}
+		
+		s = &imuFifo.q[imuFifo.head];
+		s->timestamp = imuFifo.countUs - (uint32_t)(imuFifo.backlog - 1 - i) * IMU_FIFO_PERIOD_US;
+		s->accel[0] = imu.accel.x;
+		s->accel[1] = imu.accel.y;
+		s->accel[2] = imu.accel.z;
+		s->gyro[0] = imu.gyro.x;
+		s->gyro[1] = imu.gyro.y;
+		s->gyro[2] = imu.gyro.z;
+		s->temp = imuTemp;
+		imuFifo.head = next;
+	}
+}
+
+//Oldest IMU sample (FIFO mode). Returns 0 when the queue is empty.
+uint8_t imu_fifo_pop(struct imu_sample_s *s)
+{
+	if(imuFifo.tail == imuFifo.head)
+	{
+		return 0;
+	}
+	
+	*s = imuFifo.q[imuFifo.tail];
+	imuFifo.tail = (imuFifo.tail + 1) & IMU_FIFO_QUEUE_MASK;
+	
+	return 1;
 }
 
 //// LOW LEVEL FUNCTIONS /////
@@ -163,9 +301,10 @@ int imu_write(uint8_t internal_reg_addr, uint8_t* pData, uint16_t length)
 	//Try to write it up to 5 times
 	for(i = 0; i < 5; i++)
 	{
-		stat = I2C_0_MasterWriteBuf(IMU_ADDR, (uint8_t *) i2c_tmp_buf, length + 1, I2C_0_MODE_COMPLETE_XFER);
+		//Queued, the ISR sends it:
+		stat = i2c0_write(IMU_ADDR, (uint8_t *) i2c_tmp_buf, length + 1);
 		
-		if(stat == I2C_0_MSTR_NO_ERROR)
+		if(stat == 0)
 		{
 			break;
 		}
@@ -216,8 +355,7 @@ void imu_test_code_blocking(void)
 	// 3 channels test (only one displayed)
 	while(1)
 	{
-		get_accel_xyz();
-		//get_gyro_xyz();
+		get_imu_burst();
 		#ifdef USE_USB
 		send_usb_int16_t(imu.gyro.z);
 		#endif	//USE_USB
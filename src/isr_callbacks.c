@@ -48,6 +48,17 @@
 #include "mag_encoders.h"
 #include "sensor_commut.h"
 #include "user-ex.h"
+#include "foc.h"
+#include "motor_id.h"
+#include "fsm_timing.h"
+#include "datalog.h"
+#include "i2c.h"
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static void as5047_sample_isr(uint16 word);
 
 //****************************************************************************
 // Public Function(s)
@@ -73,16 +84,13 @@ void isr_t1_Interrupt_InterruptCallback()
 
 void isr_t2_Interrupt_InterruptCallback()
 {
-	//Timer 2: 10us delay. RS-485 transceiver.
+	//Timer 2: RS-485 transceiver (one-shot)
 	
 	//Clear interrupt
 	Timer_2_ReadStatusRegister();
 	isr_t2_ClearPending();	
 	
-	//Transfer is over, enable Receiver & disable Emitter
-	UART_DMA_XMIT_Write(0);		//No transmission
-	DE_Write(0);
-	NOT_RE_Write(0);
+	rs485_t2_isr();
 	
 	T2_RESET_Write(1);	
 }
@@ -119,6 +127,8 @@ void isr_sar1_dma_Interrupt_InterruptCallback()
 static uint8 update_current_flag = 0;
 void isr_sar2_dma_Interrupt_InterruptCallback()
 {	
+	sampleStamp.adc = STAMP_NOW();
+	
 	#if((MOTOR_COMMUT == COMMUT_BLOCK) && (CURRENT_SENSING == CS_LEGACY))
 		
 		volatile int32 adc_sum = 0;
@@ -148,14 +158,12 @@ void isr_dma_uart_rx_Interrupt_InterruptCallback()
 	//Update rx_buf with the latest DMA data:
 	//unwrap_buffer(uart_dma_rx_buf, uart_dma_rx_buf_unwrapped, 48);
 	//update_rx_buf_array_485(uart_dma_rx_buf_unwrapped, 48);		//ToDo shouldn't be harcoded. Buffer name?
-	update_rx_buf_485(uart_dma_rx_buf, 48);
-	commPeriph[PORT_RS485_1].rx.bytesReadyFlag++;
+	rs485_rx_dma_isr();
 }
 
 void isr_dma_uart_tx_Interrupt_InterruptCallback()
 {
-	T2_RESET_Write(0);
-	Timer_2_Start();		
+	rs485_tx_dma_isr();
 }
 
 void isr_dma_uart_bt_rx_Interrupt_InterruptCallback()
@@ -178,15 +186,13 @@ void ADC_SAR_1_ISR_InterruptCallback()
 	//Not used anymore
 }
 
-//SPI - AS5047 position sensor
+//SPI - AS5047 position sensor, one interrupt per word
 void isr_spi_tx_Interrupt_InterruptCallback()
 {
 	#ifdef USE_AS5047
 
 	//static volatile uint16 frame_errors = 0, parity_errors = 0, man_test = 0;
 	volatile uint8_t tx_status_isr = 0;
-	static uint16 counter = 0;
-	static uint8 velcounter = 0;
 	
 	//Read status to clear flag:
 	tx_status_isr = SPIM_1_ReadTxStatus();
@@ -204,31 +210,7 @@ void isr_spi_tx_Interrupt_InterruptCallback()
 	{
 		//Transfer complete, decode answer:
 		spidata_miso[spi_isr_state] = SPIM_1_ReadRxData();
-		as5047_angle = (spidata_miso[spi_isr_state] & 0x3FFF);
-		spi_read_flag = 1;
-		update_as504x_absang(as5047_angle, &as5047);
-		sensor_sin_commut(as5047.ang_comp_clks >> 3, exec1.sine_commut_pwm);
-
-		if(update_current_flag)
-		{
-			update_current_arrays();
-			update_current_flag = 0;
-		}
-		
-		if(velcounter >= 20)
-		{
-			//Encoder velocity estimation:
-			//update_as504x_contang(&as5047);
-			update_as504x_vel(&as5047);
-			velcounter = 0;		   
-		}
-		velcounter++;
-
-		if(counter < 20000)
-		{
-			if(counter > 14000){set_current_zero();}
-			counter++;
-		}
+		as5047_sample_isr(spidata_miso[spi_isr_state]);
 		
 		/* Partially developped error testing code:
 		
@@ -255,6 +237,8 @@ void isr_spi_tx_Interrupt_InterruptCallback()
 //Interrupt triggers when PWM A reloads
 void isr_mot_Interrupt_InterruptCallback()
 {
+	sampleStamp.pwm = STAMP_NOW();
+	
 	//Encoder, sine commutation:
 	#if(MOTOR_COMMUT == COMMUT_SINE) 
 
@@ -265,3 +249,92 @@ void isr_mot_Interrupt_InterruptCallback()
 
 	#endif	//(MOTOR_COMMUT == COMMUT_SINE)
 }
+
+//End of the I2C_0 component ISR: transaction queue
+void I2C_0_ISR_ExitCallback()
+{
+	i2c0_isr();
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+//New AS5047 angle (last word of the read): commutation, current & datalog
+static void as5047_sample_isr(uint16 word)
+{
+	#ifdef USE_AS5047
+	
+	static uint16 counter = 0;
+	static uint8 velcounter = 0;
+	
+	sampleStamp.ang = STAMP_NOW();
+	FSM_TIMING_START(tIsr);
+	as5047_angle = (word & 0x3FFF);
+	spi_read_flag = 1;
+	#if(VEL_ESTIMATOR == VEL_EST_PLL)
+	update_as5047_vel_pll(as5047_angle);
+	#endif
+	update_as504x_absang(as5047_angle, &as5047);
+	
+	#if(defined(CURRENT_LOOP_IN_ISR) && !defined(USE_FOC))
+	//Current loop first, the commutation uses its output right away:
+	if(update_current_flag)
+	{
+		update_current_arrays();
+		update_current_flag = 0;
+		current_loop_isr();
+	}
+	#endif	//CURRENT_LOOP_IN_ISR
+	
+	//Motor identification, locked rotor tests:
+	if(motorId.hold)
+	{
+		motor_id_isr();
+	}
+	else
+	#ifdef USE_FOC
+	if(foc.enabled)
+	{
+		foc_current_loop(as5047.ang_abs_clks >> 3, as5047.ang_comp_clks >> 3);
+	}
+	else
+	#endif	//USE_FOC
+	{
+		sensor_sin_commut(as5047.ang_comp_clks >> 3, exec1.sine_commut_pwm);
+	}
+
+	#if(!defined(CURRENT_LOOP_IN_ISR) || defined(USE_FOC))
+	if(update_current_flag)
+	{
+		update_current_arrays();
+		update_current_flag = 0;
+	}
+	#endif	//CURRENT_LOOP_IN_ISR
+	
+	if(velcounter >= 20)
+	{
+		//Encoder velocity estimation:
+		//update_as504x_contang(&as5047);
+		update_as5047_vel();
+		velcounter = 0;		   
+	}
+	velcounter++;
+
+	if(counter < 20000)
+	{
+		if(counter > 14000){set_current_zero();}
+		counter++;
+	}
+	
+	#ifdef USE_DATALOG
+	datalog_isr();
+	#endif	//USE_DATALOG
+	FSM_TIMING_STOP_ISR(tIsr);
+	
+	#else
+	
+	(void)word;
+	
+	#endif	//USE_AS5047
+}
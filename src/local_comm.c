@@ -42,15 +42,37 @@
 #include "flexsea_sys_def.h"
 #include <flexsea_comm.h>
 #include "flexsea_comm_multi.h"
+#include "fsm_timing.h"
+#include "datalog.h"
+#include <string.h>
 
 //****************************************************************************
 // Variable(s)
 //****************************************************************************
 
+static MultiPacketInfo pInfo;
+static int sinceLastStreamSend[MAX_STREAMS] = {0};
+
+//Stream scheduler:
+struct stream_stats_s streamStats[MAX_STREAMS];
+static uint8_t bundle[MAX_STREAMS], bundleN = 0;
+static uint16_t bundleLen[MAX_STREAMS];
+//Bundle replies are built here first (same size as the reply buffer):
+static uint8_t streamScratch[sizeof(((MultiWrapper *)0)->unpacked)];
+static uint16_t scratchLen = 0;
+static uint8_t scratchStream = STREAM_NONE;
+static uint8_t streamSentFlag[MAX_STREAMS];
+static uint8_t streamReq[8];
+
 //****************************************************************************
 // Private Function Prototype(s):
 //****************************************************************************	
 
+static uint8_t streamsDue(uint8_t *order);
+static uint8_t streamBefore(uint8_t a, uint8_t b);
+static void streamSent(uint8_t s, uint16_t len);
+static void streamStatsUpdate(void);
+
 //****************************************************************************
 // Public Function(s)
 //****************************************************************************
@@ -69,6 +91,9 @@ void initLocalComm(void)
 				comm_str[i], rx_command[i], &rx_buf_circ[i], \
 				&packet[i][INBOUND], &packet[i][OUTBOUND]);
 	}
+
+	flexsea_multipayload_ptr[CMD_STREAM_BUNDLE][RX_PTYPE_READ] = &rx_multi_cmd_stream_bundle_rr;
+	flexsea_multipayload_ptr[CMD_STREAM_STATS][RX_PTYPE_READ] = &rx_multi_cmd_stream_stats_rr;
 }
 
 //Did we receive new commands? Can we parse them?
@@ -107,87 +132,333 @@ void parseMasterCommands(uint8_t *new_cmd)
 //Call this to send any pending delayed reply on RS-485
 void sendMasterDelayedResponse(void)
 {
-	Port port = PORT_RS485_1;
-	
-	if(commPeriph[port].tx.packetReady == 1)
-	{
-		//We never replied in the same time slot:
-		if(t1_time_share == commPeriph[port].tx.timeStamp)
-		{
-			//rs485_puts(reply_ready_buf, reply_ready_len);
-			rs485_puts(packet[port][OUTBOUND].packed, \
-						packet[port][OUTBOUND].numb);
-			
-			//Drop flag
-			commPeriph[port].tx.packetReady = 0;
-		}		
-	}
+	//Queued by rs485DelayedTransmit(), sent when due:
+	rs485_reply_service();
 }
 
 uint8_t isMultiAutoStream(uint8_t cmdCode) {
-	return cmdCode == CMD_SYSDATA;
+	return (cmdCode == CMD_SYSDATA) || (cmdCode == CMD_FSM_TIMING) || \
+			(cmdCode == CMD_DATALOG);
 }
 
-static MultiPacketInfo pInfo;
-static int sinceLastStreamSend[MAX_STREAMS] = {0};
-
+//Streams are served earliest deadline first. The multi-packet streams due on
+//a port for the same receiver go out in one frame (CMD_STREAM_BUNDLE when there
+//is more than one), up to STREAM_BUNDLE_MAX_LEN; single packet streams are
+//limited to one per call. What doesn't fit (or is for another receiver) waits
+//for the next call, with a higher priority. Only the streams actually sent
+//are counted in streamStats[].
 void autoStream(void)
 {
-	if(isStreaming)
+	uint8_t order[MAX_STREAMS];
+	uint8_t i = 0, n = 0, port = 0, s = 0;
+	MultiCommPeriph *cp;
+
+	if(!isStreaming)
+	{
+		return;
+	}
+
+	for(i = 0; i < isStreaming; i++)
+	{
+		sinceLastStreamSend[i]++;
+	}
+	streamStatsUpdate();
+
+	n = streamsDue(order);
+	if(!n)
 	{
-		int i;
-		for(i = 0; i < isStreaming; i++)
+		return;
+	}
+	memset(streamSentFlag, 0, sizeof(streamSentFlag));
+
+	//Multi-packet, one frame per port:
+	for(port = 0; port < NUMBER_OF_PORTS; port++)
+	{
+		//A reply left in streamScratch goes first, the other ports wait:
+		bundleN = 0;
+		if(scratchStream != STREAM_NONE)
 		{
-			sinceLastStreamSend[i]++;
+			if(streamPortInfos[scratchStream] != port)
+			{
+				continue;
+			}
+			bundle[bundleN++] = scratchStream;
 		}
 
-		for(i = 0; i < isStreaming; i++)
+		for(i = 0; i < n; i++)
 		{
-			if(sinceLastStreamSend[i] >= streamPeriods[i])
+			s = order[i];
+			if(!isMultiAutoStream(streamCmds[s]) || (streamPortInfos[s] != port) || \
+				(s == scratchStream))
 			{
-				if(isMultiAutoStream(streamCmds[i]))
-				{
-					MultiCommPeriph *cp = comm_multi_periph + streamPortInfos[i];
-					pInfo.xid = streamReceivers[i];
-					pInfo.rid = getDeviceId();
-					pInfo.portIn = streamPortInfos[i];
-
-					// following line is a bad-practice-band-aid!
-					// we should enforce that auto-streamable commands do not read from the unpacked buffer
-					// this line forces sysdata to respond with data and not metadata regardless of the status of the comm periph
-					// TODO: resolvable by changing sysdata metadata to be a response to a write command instead of a read command
-					cp->in.unpacked[0] = 0;
-					uint8_t error = receiveAndFillResponse(streamCmds[i], RX_PTYPE_READ, &pInfo, cp);
-					if(error)
-					{
-						cp->out.unpackedIdx = 0;
-					}
-				}
-				else
+				continue;
+			}
+
+			//One receiver per frame, the most urgent stream's. Replies too long
+			//for a bundle go alone.
+			if(!bundleN)
+			{
+				bundle[bundleN++] = s;
+			}
+			else if((streamReceivers[s] == streamReceivers[bundle[0]]) && \
+					(streamStats[bundle[0]].len <= UINT8_MAX) && \
+					(streamStats[s].len <= UINT8_MAX))
+			{
+				bundle[bundleN++] = s;
+			}
+		}
+
+		cp = comm_multi_periph + port;
+		if(!bundleN || cp->out.unpackedIdx)
+		{
+			//Nothing to send, or a reply is already waiting
+			continue;
+		}
+
+		pInfo.xid = streamReceivers[bundle[0]];
+		pInfo.rid = getDeviceId();
+		pInfo.portIn = port;
+
+		if((bundleN == 1) && (bundle[0] != scratchStream))
+		{
+			//Same as a regular read reply
+			s = bundle[0];
+
+			// following line is a bad-practice-band-aid!
+			// this line forces sysdata to respond with data and not metadata regardless of the status of the comm periph
+			// (the bundle passes a zeroed request to every stream for the same reason)
+			cp->in.unpacked[0] = 0;
+			if(receiveAndFillResponse(streamCmds[s], RX_PTYPE_READ, &pInfo, cp))
+			{
+				cp->out.unpackedIdx = 0;
+			}
+			else
+			{
+				streamSent(s, cp->out.unpackedIdx);
+			}
+		}
+		else
+		{
+			//bundle[] now holds the streams that made it in the frame:
+			if(receiveAndFillResponse(CMD_STREAM_BUNDLE, RX_PTYPE_READ, &pInfo, cp))
+			{
+				cp->out.unpackedIdx = 0;
+			}
+			else
+			{
+				for(i = 0; i < bundleN; i++)
 				{
-					//Determine what offset to use:
-					streamCurrentOffset[i]++;
-					if(streamCurrentOffset[i] > streamIndex[i][1])
-					{
-						streamCurrentOffset[i] = streamIndex[i][0];
-					}
-
-					uint8_t cp_str[256] = {0};
-					cp_str[P_XID] = streamReceivers[i];
-					cp_str[P_DATA1] = streamCurrentOffset[i];
-					(*flexsea_payload_ptr[streamCmds[i]][RX_PTYPE_READ]) (cp_str, &streamPortInfos[i]);
+					streamSent(bundle[i], bundleLen[i]);
 				}
+			}
+		}
+	}
+	bundleN = 0;
 
-				sinceLastStreamSend[i] -= streamPeriods[i];
-
-				//we return to avoid sending two msgs in one cycle
-				//since counters were already incremented, we will still try to hit other stream frequencies
-				return;
+	//Single packet, the most urgent one:
+	for(i = 0; i < n; i++)
+	{
+		s = order[i];
+		if(!isMultiAutoStream(streamCmds[s]))
+		{
+			//Determine what offset to use:
+			streamCurrentOffset[s]++;
+			if(streamCurrentOffset[s] > streamIndex[s][1])
+			{
+				streamCurrentOffset[s] = streamIndex[s][0];
 			}
+
+			uint8_t cp_str[256] = {0};
+			cp_str[P_XID] = streamReceivers[s];
+			cp_str[P_DATA1] = streamCurrentOffset[s];
+			(*flexsea_payload_ptr[streamCmds[s]][RX_PTYPE_READ]) (cp_str, &streamPortInfos[s]);
+			streamSent(s, 0);
+			break;
+		}
+	}
+
+	for(i = 0; i < n; i++)
+	{
+		if(!streamSentFlag[order[i]] && (streamStats[order[i]].deferredCnt < UINT16_MAX))
+		{
+			streamStats[order[i]].deferredCnt++;
 		}
 	}
 }
 
+//Reply: [cmd, len, payload] for every stream of the bundle prepared by
+//autoStream(). Empty when called outside of autoStream(). Each payload is
+//built in streamScratch and only copied if it fits; the one that doesn't stays
+//there and opens the next bundle (streams like CMD_DATALOG can't be asked
+//twice for the same data).
+void rx_multi_cmd_stream_bundle_rr(uint8_t *msgBuf, MultiPacketInfo *info, \
+									uint8_t *responseBuf, uint16_t* responseLen)
+{
+	uint16_t index = 0;
+	uint8_t i = 0, n = 0, s = 0;
+	(void)msgBuf;
+
+	for(i = 0; i < bundleN; i++)
+	{
+		s = bundle[i];
+
+		if(scratchStream != s)
+		{
+			scratchLen = 0;
+			memset(streamReq, 0, sizeof(streamReq));
+			(*flexsea_multipayload_ptr[streamCmds[s]][RX_PTYPE_READ]) \
+				(streamReq, info, streamScratch, &scratchLen);
+			scratchStream = s;
+		}
+
+		//The length is one byte. Discarded, it will go alone next time:
+		if(scratchLen > UINT8_MAX)
+		{
+			streamStats[s].len = scratchLen;
+			scratchStream = STREAM_NONE;
+			continue;
+		}
+
+		//The first one always goes (see STREAM_BUNDLE_MAX_LEN):
+		if(index && ((index + 2 + scratchLen) > STREAM_BUNDLE_MAX_LEN))
+		{
+			break;
+		}
+
+		responseBuf[index] = streamCmds[s];
+		responseBuf[index + 1] = (uint8_t)scratchLen;
+		memcpy(&responseBuf[index + 2], streamScratch, scratchLen);
+		index += 2 + scratchLen;
+		bundle[n] = s;
+		bundleLen[n++] = scratchLen;
+		scratchStream = STREAM_NONE;
+	}
+
+	bundleN = n;
+	*responseLen = index;
+}
+
+//Reply: number of streams, then cmd, requested & achieved rates (Hz),
+//deferred calls and max lateness (ms) for each one (uint16)
+void rx_multi_cmd_stream_stats_rr(uint8_t *msgBuf, MultiPacketInfo *info, \
+									uint8_t *responseBuf, uint16_t* responseLen)
+{
+	uint16_t index = 0;
+	uint8_t i = 0;
+	(void)msgBuf;
+	(void)info;
+
+	responseBuf[index++] = isStreaming;
+	for(i = 0; i < isStreaming; i++)
+	{
+		responseBuf[index++] = streamCmds[i];
+		SPLIT_16(streamStats[i].requestedHz, responseBuf, &index);
+		SPLIT_16(streamStats[i].achievedHz, responseBuf, &index);
+		SPLIT_16(streamStats[i].deferred, responseBuf, &index);
+		SPLIT_16(streamStats[i].maxLate, responseBuf, &index);
+	}
+
+	*responseLen = index;
+}
+
 //****************************************************************************
 // Private Function(s)
 //****************************************************************************
+
+//Streams that reached their period, most overdue first (ties: shortest
+//period first). Returns the count.
+static uint8_t streamsDue(uint8_t *order)
+{
+	uint8_t i = 0, j = 0, n = 0;
+	int32_t late = 0;
+
+	for(i = 0; i < isStreaming; i++)
+	{
+		late = sinceLastStreamSend[i] - streamPeriods[i];
+		if(late < 0)
+		{
+			continue;
+		}
+
+		if(late > streamStats[i].maxLateCnt) {streamStats[i].maxLateCnt = late;}
+
+		//Insertion sort, MAX_STREAMS is small:
+		for(j = n; j > 0; j--)
+		{
+			if(streamBefore(order[j - 1], i))
+			{
+				break;
+			}
+			order[j] = order[j - 1];
+		}
+		order[j] = i;
+		n++;
+	}
+
+	return n;
+}
+
+//Is stream a due before stream b?
+static uint8_t streamBefore(uint8_t a, uint8_t b)
+{
+	int32_t lateA = sinceLastStreamSend[a] - streamPeriods[a];
+	int32_t lateB = sinceLastStreamSend[b] - streamPeriods[b];
+
+	if(lateA != lateB)
+	{
+		return (lateA > lateB);
+	}
+
+	return (streamPeriods[a] <= streamPeriods[b]);
+}
+
+//Next deadline one period after the last one. More than a period behind, we
+//skip the missed ones rather than sending a burst.
+static void streamSent(uint8_t s, uint16_t len)
+{
+	sinceLastStreamSend[s] -= streamPeriods[s];
+	if(sinceLastStreamSend[s] >= streamPeriods[s])
+	{
+		sinceLastStreamSend[s] = 0;
+	}
+
+	if(len) {streamStats[s].len = len;}
+	if(streamStats[s].sent < UINT16_MAX) {streamStats[s].sent++;}
+	streamSentFlag[s] = 1;
+}
+
+static void streamStatsUpdate(void)
+{
+	static uint16_t ticks = 0;
+	static uint8_t lastIsStreaming = 0;
+	struct stream_stats_s *st;
+	uint8_t i = 0;
+
+	//New stream configuration:
+	if(isStreaming != lastIsStreaming)
+	{
+		memset(streamStats, 0, sizeof(streamStats));
+		scratchStream = STREAM_NONE;
+		lastIsStreaming = isStreaming;
+		ticks = 0;
+	}
+
+	ticks++;
+	if(ticks < STREAM_STATS_WINDOW)
+	{
+		return;
+	}
+	ticks = 0;
+
+	for(i = 0; i < isStreaming; i++)
+	{
+		st = &streamStats[i];
+		st->requestedHz = (streamPeriods[i]) ? (1000 / streamPeriods[i]) : 1000;
+		st->achievedHz = (uint16_t)(((uint32_t)st->sent * 1000) / STREAM_STATS_WINDOW);
+		st->deferred = st->deferredCnt;
+		st->maxLate = st->maxLateCnt;
+		st->sent = 0;
+		st->deferredCnt = 0;
+		st->maxLateCnt = 0;
+	}
+}
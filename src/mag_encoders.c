@@ -37,15 +37,16 @@
 #include "mag_encoders.h"
 #include "user-ex.h"
 #include "filters.h"
+#include "ringbuf.h"
 #include "flexsea_global_structs.h"
 #include "dynamic_user_structs.h"
+#include "motor.h"
+#include "fsm_timing.h"
 
 //****************************************************************************
 // Variable(s)
 //****************************************************************************
 
-int32 angtimer_read = 65000;
-
 volatile struct as504x_s as5047, as5048b;
 
 //Magnetic encoder, AS5047:
@@ -62,11 +63,31 @@ uint8_t as5048b_bytes[10] = {0,0,0,0,0,0,0,0,0,0};
 uint8_t as5048b_agc = 0, as5048b_diag = 0;
 uint16 as5048b_mag = 0, as5048b_angle = 0;
 
+//Velocity estimator:
+struct vel_pll_s velPll;
+static struct ringbuf_s angRing;
+
+//update_as504x() filters, one set per encoder:
+struct as504x_filt_s
+{
+	struct lpf1_s vel, velCtrl, ang;
+	int32_t fs;
+};
+static struct as504x_filt_s as5047Filt, as5048bFilt;
+//Velocity, control velocity and angle cut-offs for each supported rate:
+static const int32_t as504xFiltFs[3] = {10000, 1000, 250};
+static const struct lpf1_s as504xLpf[3][3] = {
+	{LPF1_INIT(5, 10000), LPF1_INIT(10, 10000), LPF1_INIT(20, 10000)},
+	{LPF1_INIT(20, 1000), LPF1_INIT(10, 1000), LPF1_INIT(20, 1000)},
+	{LPF1_INIT(20, 250), LPF1_INIT(10, 250), LPF1_INIT(20, 250)}};
+
 //****************************************************************************
 // Private Function Prototype(s):
 //****************************************************************************	
 
 static uint16 add_even_parity_msb(uint16 word);
+static int32_t ang_extrapolate(int32_t ang, int32_t vel_cpms, int32_t us);
+static struct as504x_filt_s *as504x_filt(struct as504x_s *as504x);
 
 //****************************************************************************
 // Function(s)
@@ -109,41 +130,57 @@ uint16 as5047_read_single_isr(uint16 reg)
 	return 0;
 }
 
-//Get latest readings from the AS5048B position sensor
+//Get latest readings from the AS5048B position sensor (blocking)
 void get_as5048b_position(void) 
 {
-	i2c0_read(I2C_ADDR_AS5048B, AD5048B_REG_ANGLE_H, as5048b_bytes, 2);
+	if(i2c0_read(I2C_ADDR_AS5048B, AD5048B_REG_ANGLE_H, as5048b_bytes, 2) == I2C0_READ_OK)
+	{
+		as5048b_decode(as5048b_bytes);
+	}
 }
 
-void init_angle_timer(void)
+//I2C0 queue decoder (angle, 2 bytes), called from the ISR
+void as5048b_decode(uint8_t *buf)
 {
-	Timer_angleread_Start();
+	reset_ang_counter(&as5048b);
+	update_as504x((buf[0] << 6) + (buf[1] & 0x3F), &as5048b);
 }
 
-//update the number of counts since the last time the angle sensor was read
+//update the time (us) since the last time the angle sensor was read
+//(last_angtimer_read holds the STAMP_NOW() of that read)
 void update_counts_since_last_ang_read(struct as504x_s *as504x)
 {
-	angtimer_read = Timer_angleread_ReadCounter(); 
-	
-	if (angtimer_read>as504x->last_angtimer_read+20000)
-	{
-		as504x->counts_since_last_ang_read =  as504x->counts_since_last_ang_read + as504x->last_angtimer_read+65000-angtimer_read;
-	}
-	else
-	{
-		as504x->counts_since_last_ang_read = as504x->counts_since_last_ang_read + as504x->last_angtimer_read-angtimer_read;
-	}
-	as504x->last_angtimer_read = angtimer_read;
+	as504x->counts_since_last_ang_read = STAMP_DIFF_US(STAMP_NOW(), (uint32_t)as504x->last_angtimer_read);
 }
 
-//resent the angle read counter and store the the counts between last two readings
+//timestamp a new reading and store the time (us) between the last two readings
 void reset_ang_counter(struct as504x_s *as504x)
 {
-	update_counts_since_last_ang_read(as504x);
-	as504x->last_ang_read_period = as504x->counts_since_last_ang_read-0;
+	uint32_t now = STAMP_NOW();
+	
+	as504x->last_ang_read_period = STAMP_DIFF_US(now, (uint32_t)as504x->last_angtimer_read);
+	as504x->last_angtimer_read = (int32_t)now;
 	as504x->counts_since_last_ang_read = 0;
 }
 
+//Time (us) from 'stamp' (STAMP_NOW()) to the commutation target, see
+//PWM_LEAD_US. The PWM is free-running: an old reload time still gives the phase.
+int32_t pwm_lead_us(uint32_t stamp)
+{
+	int32_t since = STAMP_DIFF_US(stamp, sampleStamp.pwm);
+	
+	if(since < 0)
+	{
+		since = 0;
+	}
+	else if(since >= PWM_PERIOD_US)
+	{
+		since %= PWM_PERIOD_US;
+	}
+	
+	return PWM_LEAD_US - since;
+}
+
 //Initialize encoder structures
 void init_as504x(struct as504x_s *as504x)
 {
@@ -185,12 +222,41 @@ void init_angsense(struct angsense_s *as)
 	as ->vel_rpm = 0;
 }
 
+//Filter state of this encoder, (re)loaded when its sampling rate changes.
+//NULL: unsupported rate, no filtering.
+static struct as504x_filt_s *as504x_filt(struct as504x_s *as504x)
+{
+	struct as504x_filt_s *f = (as504x == (struct as504x_s *)&as5047) ? \
+								&as5047Filt : &as5048bFilt;
+	uint8_t i = 0;
+	
+	if(as504x->samplefreq && (f->fs == as504x->samplefreq)){return f;}
+	
+	for(i = 0; i < 3; i++)
+	{
+		if(as504xFiltFs[i] == as504x->samplefreq)
+		{
+			f->vel = as504xLpf[i][0];
+			f->velCtrl = as504xLpf[i][1];
+			f->ang = as504xLpf[i][2];
+			lpf1_reset(&f->vel, (int32_t)as504x->raw.vels_cpms[0]);
+			lpf1_reset(&f->velCtrl, (int32_t)as504x->raw.vels_ctrl_cpms[0]);
+			lpf1_reset(&f->ang, (int32_t)as504x->raw.angs_clks[0]);
+			f->fs = as504x->samplefreq;
+			return f;
+		}
+	}
+	
+	return NULL;
+}
+
 //update all of the angle variables
 void update_as504x(int32_t ang, struct as504x_s *as504x)
 {	  
 	static int64_t raw_ang, raw_vel, raw_ctrl_vel;
 	static int64_t avg_ang_sum;
 	static int64_t avg_angs[11] = {0,0,0,0,0,0,0,0,0,0,0};
+	struct as504x_filt_s *f = NULL;
 	
 	//determine if the encoder has rotated past 0/16383 point and in what direction
 	if (ang-as504x->ang_abs_clks<-5000)
@@ -231,25 +297,21 @@ void update_as504x(int32_t ang, struct as504x_s *as504x)
 	//raw_vel = (raw_ang-as504x->raw.angs_clks[10]); //clicks per ms //has to be raw_ang since raw.angs_clks[0] has not been updated yet. 
 	raw_ctrl_vel = as504x->raw.vels_cpms[0]*10;
 	
-   
-	if (as504x->samplefreq == 10000)
-	{
-		as504x->filt.vel_cpms = filt_array_10khz(as504x->raw.vels_cpms, as504x->filt.vels_cpms,5,raw_vel);
-		as504x->filt.vel_ctrl_cpms = filt_array_10khz(as504x->raw.vels_ctrl_cpms, as504x->filt.vels_ctrl_cpms,10,raw_ctrl_vel);
-		as504x->filt.ang_clks = filt_array_10khz(as504x->raw.angs_clks, as504x->filt.angs_clks,20,raw_ang);
-	}
-	else if (as504x->samplefreq == 250)
+	//history used below (angs_clks[0], vels_cpms[0]):
+	as504x->raw.angs_clks[1] = as504x->raw.angs_clks[0];
+	as504x->raw.angs_clks[0] = raw_ang;
+	as504x->raw.vels_cpms[1] = as504x->raw.vels_cpms[0];
+	as504x->raw.vels_cpms[0] = raw_vel;
+	as504x->raw.vels_ctrl_cpms[1] = as504x->raw.vels_ctrl_cpms[0];
+	as504x->raw.vels_ctrl_cpms[0] = raw_ctrl_vel;
+	
+	f = as504x_filt(as504x);
+	if(f != NULL)
 	{
-		as504x->filt.vel_cpms = filt_array_250hz(as504x->raw.vels_cpms, as504x->filt.vels_cpms,20,raw_vel);
-		as504x->filt.vel_ctrl_cpms = filt_array_250hz(as504x->raw.vels_ctrl_cpms, as504x->filt.vels_ctrl_cpms,10,raw_ctrl_vel);
-		as504x->filt.ang_clks = filt_array_250hz(as504x->raw.angs_clks, as504x->filt.angs_clks,20,raw_ang);
+		as504x->filt.vel_cpms = lpf1_run(&f->vel, (int32_t)raw_vel);
+		as504x->filt.vel_ctrl_cpms = lpf1_run(&f->velCtrl, (int32_t)raw_ctrl_vel);
+		as504x->filt.ang_clks = lpf1_run(&f->ang, (int32_t)raw_ang);
 	}
-	else if (as504x->samplefreq == 1000)
-	{
-		as504x->filt.vel_cpms = filt_array_1khz(as504x->raw.vels_cpms, as504x->filt.vels_cpms,20,raw_vel);
-		as504x->filt.vel_ctrl_cpms = filt_array_1khz(as504x->raw.vels_ctrl_cpms, as504x->filt.vels_ctrl_cpms,10,raw_ctrl_vel);
-		as504x->filt.ang_clks = filt_array_1khz(as504x->raw.angs_clks, as504x->filt.angs_clks,20,raw_ang);
-	}	
 	
 	//calculate the derived angular terms
 	as504x->raw.ang_clks = as504x->raw.angs_clks[0];
@@ -263,21 +325,33 @@ void update_as504x(int32_t ang, struct as504x_s *as504x)
 	as504x->signed_ang = -1 * avg_angs[0] * MOTOR_ORIENTATION;
 	as504x->signed_ang_vel = -1 * as504x->filt.vel_cpms * MOTOR_ORIENTATION;
 	
-	//update the 1 MHz counts from the last angle read
+	//update the time since the last angle read
 	update_counts_since_last_ang_read(as504x);
 	
-	//Update the velocity compensated angle//as504x->counts_since_last_ang_read+
-	as504x->ang_comp_clks = ((((as504x->counts_since_last_ang_read+53)*(as504x->filt.vel_cpms))/1000+(as504x->ang_abs_clks)+16384)%16384); 
+	//Update the velocity compensated angle. Joint encoder (I2C, 1kHz): the
+	//angle now, not at the PWM reload (pwm_lead_us() is for commutation)
+	as504x->ang_comp_clks = ang_extrapolate(as504x->ang_abs_clks, as504x->filt.vel_cpms, \
+							as504x->counts_since_last_ang_read);
 }
 
 void update_as504x_absang(int32_t ang, struct as504x_s *as504x)
 {	
+	//Sampled at sampleStamp.ang (AS5047):
 	as504x->ang_abs_clks = ang;
-	as504x->ang_comp_clks = ((((66)*(as504x->filt_vel_cpms))/1000+(as504x->ang_abs_clks)+16384)%16384);
+	as504x->ang_comp_clks = ang_extrapolate(ang, as504x->filt_vel_cpms, pwm_lead_us(sampleStamp.ang));
+}
+
+//Reset the AS5047 velocity estimator state (ring & PLL)
+void init_as5047_vel(void)
+{
+	ringbuf_init(&angRing, 5);
+	velPll.init = 0;
 }
 
-void update_as504x_vel(struct as504x_s *as504x)
+//AS5047 turns & signed angle (1kHz), and the velocity with VEL_EST_DIFF
+void update_as5047_vel(void)
 {   
+	struct as504x_s *as504x = (struct as504x_s *)&as5047;
 	static int64_t last_ang_abs_clks = 0;	
 	//determine if the encoder has rotated past 0/16383 point and in what direction
 	if (as504x->ang_abs_clks-last_ang_abs_clks<-5000)
@@ -291,11 +365,40 @@ void update_as504x_vel(struct as504x_s *as504x)
 	last_ang_abs_clks = as504x->ang_abs_clks;
 	update_diffarr(&as504x->raw_angs_clks,((as504x->num_rot<<14)+as504x->ang_abs_clks),2);
 
-	as504x->filt_vel_cpms = get_vel_1k_5samples(&as504x->raw_angs_clks)/1000;
-
 	as504x->signed_ang =  as504x->raw_angs_clks.curval * MOTOR_ORIENTATION;
+	
+	#if(VEL_ESTIMATOR == VEL_EST_DIFF)
+	//5 samples regression, same result as get_vel_1k_5samples()/1000
+	ringbuf_push(&angRing, (int32_t)as504x->raw_angs_clks.curval);
+	as504x->filt_vel_cpms = ringbuf_slope(&angRing, 1);
 	as504x->signed_ang_vel = as504x->filt_vel_cpms * MOTOR_ORIENTATION;
+	#endif
+}
 
+//AS5047 angle tracking loop, call with every new encoder reading (0-16383),
+//before update_as504x_absang(). Type 2: no steady state error at constant
+//speed. 32-bit, no history.
+void update_as5047_vel_pll(int32_t ang)
+{
+	struct vel_pll_s *p = &velPll;
+	
+	if(!p->init)
+	{
+		p->ang = (uint32_t)ang << VEL_PLL_ANG_SHIFT;
+		p->vel = 0;
+		p->init = 1;
+	}
+	
+	//Prediction, then correction. The error wraps like the encoder.
+	p->ang += (uint32_t)p->vel;
+	p->err = (int32_t)(((uint32_t)ang << VEL_PLL_ANG_SHIFT) - p->ang);
+	p->ang += (uint32_t)(p->err >> VEL_PLL_KP_SHIFT);
+	p->vel += p->err >> VEL_PLL_KI_SHIFT;
+	
+	//Counts per ms. Includes the proportional correction (slope of the
+	//estimated angle), the integrator alone lags by 2/wn.
+	as5047.filt_vel_cpms = (((p->vel + (p->err >> VEL_PLL_KP_SHIFT)) >> 8) * VEL_PLL_READS_PER_MS) >> (VEL_PLL_ANG_SHIFT - 8);
+	as5047.signed_ang_vel = as5047.filt_vel_cpms * MOTOR_ORIENTATION;
 }
 
 //****************************************************************************
@@ -321,6 +424,12 @@ static uint16 add_even_parity_msb(uint16 word)
 	return ret;
 }
 
+//Angle 'us' later at 'vel_cpms' (counts/ms), 0-16383
+static int32_t ang_extrapolate(int32_t ang, int32_t vel_cpms, int32_t us)
+{
+	return (((us * vel_cpms) / 1000 + ang + 16384) % 16384);
+}
+
 //****************************************************************************
 // Test Function(s) - Use with care!
 //****************************************************************************
@@ -46,6 +46,12 @@
 #include "flexsea_system.h"
 #include "misc.h"
 #include "flexsea_user_structs.h"
+#include "fsm_timing.h"
+#include "datalog.h"
+
+#ifdef SIM_HOST
+#include "sim_hal.h"
+#endif	//SIM_HOST
 
 //****************************************************************************
 // Variable(s)
@@ -63,11 +69,13 @@ void (*fsmCases[10])(void) = {&mainFSM0, &mainFSM1, &mainFSM2, &mainFSM3, \
 // for example: inlining a recursive function into itself is only done once
 __attribute__((always_inline)) __STATIC_INLINE void runFSM(uint8_t index)
 {
+	FSM_TIMING_START(t0);
 	activeFSM = index;
 	//DEBUG_H2(1);
 	fsmCases[index]();
 	//DEBUG_H2(0);
 	activeFSM = FSMS_INACTIVE;
+	FSM_TIMING_STOP(index, t0);
 }
 
 int main(void)
@@ -78,6 +86,8 @@ int main(void)
 	//Prepare FlexSEA Stack & communication:
 	init_flexsea_payload_ptr();
 	initLocalComm();
+	initFsmTiming();
+	initDatalog();
 
 	//Initialize all the peripherals
 	init_peripherals();
@@ -111,18 +121,39 @@ int main(void)
 			t1_new_value = 0;			
 			
             runFSM(t1_time_share);
+			#ifdef USE_FSM_TIMING
+			uint8_t lastSlot = t1_time_share;
+			#endif	//USE_FSM_TIMING
 
 			//Increment value, limits to 0-9
 			TICK_COUNTER(t1_time_share, 10);
             
 			//The code below is executed every 100us, after the previous slot. 
 			//Keep it short! (<10us if possible)
+			FSM_TIMING_START(t0);
 			mainFSM10kHz();
+			FSM_TIMING_STOP(FSM_TIMING_10KHZ, t0);
+			
+			#ifdef USE_FSM_TIMING
+			fsmTimingCheckOverrun(lastSlot);
+			#endif	//USE_FSM_TIMING
 		}
 		else
 		{
 			//Asynchronous code goes here.
 			mainFSMasynchronous();
+			
+			#ifdef SIM_HOST
+			//Host simulation: jump to the next event, stop after SIM_TICKS
+			if(simHalIdle())
+			{
+				break;
+			}
+			#endif	//SIM_HOST
 		}
 	}
+	
+	#ifdef SIM_HOST
+	return 0;
+	#endif	//SIM_HOST
 }
@@ -59,6 +59,10 @@
 #include "user-ex.h"
 #include <flexsea_board.h>
 #include "flexsea_comm_multi.h"
+#include "foc.h"
+#include "current_sensing.h"
+#include "cogging.h"
+#include "motor_id.h"
 
 //****************************************************************************
 // Variable(s)
@@ -258,7 +262,7 @@ void mainFSM7(void)
 //Case 8: SAR ADC filtering
 void mainFSM8(void)
 {
-	update_diffarr_avg(&ctrl[0].current.actual_vals,50);
+	ctrl[0].current.actual_vals.avg = ringbuf_mean(&currentRing);
 	calc_motor_L();
 	if(adc_sar1_flag)
 	{
@@ -278,6 +282,20 @@ void mainFSM9(void)
 			calibrationFlags = 0;
 		}
 	}
+	else if(calibrationFlags & CALIBRATION_COGGING)
+	{
+		if(!cogging_calibration())
+		{
+			calibrationFlags = 0;
+		}
+	}
+	else if(calibrationFlags & CALIBRATION_MOTOR_ID)
+	{
+		if(!motor_id_calibration())
+		{
+			calibrationFlags = 0;
+		}
+	}
 	else
 	{
 		#if(RUNTIME_FSM == ENABLED)
@@ -322,6 +340,10 @@ void mainFSM10kHz(void)
 		{
 			transmitMultiFrame();
 		}
+		
+		#ifdef USE_USB
+		usb_tx_service();
+		#endif	//USE_USB
 	
 	#endif	//USE_COMM 
 	
@@ -331,11 +353,20 @@ void mainFSM10kHz(void)
 		if((calibrationFlags == 0) && ((ctrl[0].active_ctrl == CTRL_CURRENT) || (ctrl[0].active_ctrl == CTRL_IMPEDANCE)))
 		{
 			//Current controller
+			#if defined(USE_FOC)
+			foc_set_current(ctrl[0].current.setpoint_val, 0);
+			#elif defined(CURRENT_LOOP_IN_ISR)
+			//Done in the SPI ISR, see current_loop_isr()
+			#else
 			motor_current_pid_3(ctrl[0].current.setpoint_val, ctrl[0].current.actual_vals.avg, 0);
+			#endif	//USE_FOC
 		}
 		else
 		{
 			ctrl[0].current.error_sum = 0;
+			#ifdef USE_FOC
+			foc_disable();
+			#endif	//USE_FOC
 		}
 		
 	#endif
@@ -87,6 +87,10 @@ void save_angles_to_eeprom(uint16_t *new_angles, eepromTable table)
 			rowStart = EE_ANGLE_JOINT_START;
 			rowLim = EE_ANGLE_JOINT_START + EE_ANGLE_JOINT_LEN;
 			break;
+		case MOTOR_ID:
+			rowStart = EE_MOTOR_ID_START;
+			rowLim = EE_MOTOR_ID_START + EE_MOTOR_ID_LEN;
+			break;
 		default:
 			return;	//Error, quit function
 	}
@@ -129,6 +133,10 @@ void load_angles_from_eeprom(uint16_t *ee_angles, eepromTable table)
 			wordStart = EE_ANGLE_JOINT_START * EE_ROW_LEN_WORD;
 			wordLim = wordStart + (EE_ANGLE_JOINT_LEN * EE_ROW_LEN_WORD);
 			break;
+		case MOTOR_ID:
+			wordStart = EE_MOTOR_ID_START * EE_ROW_LEN_WORD;
+			wordLim = wordStart + (EE_MOTOR_ID_LEN * EE_ROW_LEN_WORD);
+			break;
 		default:
 			return;	//Error, quit function
 	}
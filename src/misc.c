@@ -184,6 +184,10 @@ void test_code_blocking(void)
 	//as5048b_test_code_blocking();
 	//rgbLedRefresh_testcode_blocking();
 	//compress6chTestCodeBlocking();
+	//fixed_math_sin_test_code_blocking();
+	//modulation_test();
+	//current_loop_benchmark();
+	//filters_benchmark();
 	//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=	
 }
 
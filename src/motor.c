@@ -49,6 +49,8 @@
 #include "sensor_commut.h"
 #include "dynamic_user_structs.h"
 #include "main_fsm.h"
+#include "cogging.h"
+#include "motor_id.h"
 
 //****************************************************************************
 // Variable(s)
@@ -110,8 +112,16 @@ void init_motor(void)
 	#ifdef USE_FLASH
 	init_flash();
 	#endif	//USE_FLASH
+	
+	#ifdef USE_COGGING_COMP
+	init_cogging();
+	#endif	//USE_COGGING_COMP
 		
 	#endif	//(MOTOR_COMMUT == COMMUT_BLOCK)
+	
+	//Motor parameters (current loop feed-forward), used by all the current
+	//controllers:
+	init_motor_id();
 
 	//Quadrature 1: Motor shaft encoder
 	#ifdef USE_QEI
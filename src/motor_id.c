@@ -0,0 +1,441 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-execute' Advanced Motion Controller
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] motor_id: motor parameter identification (R, L, Ke, inertia)
+	& current loop feed-forward terms
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-17 | agent | Initial release
+	*
+****************************************************************************/
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include "main.h"
+#include "motor_id.h"
+#include "motor.h"
+#include "sensor_commut.h"
+#include "current_sensing.h"
+#include "mag_encoders.h"
+#include "mem_angle.h"
+#include "safety.h"
+#include "main_fsm.h"
+#include "flexsea_global_structs.h"
+#include <string.h>
+
+//****************************************************************************
+// Variable(s)
+//****************************************************************************
+
+struct motor_id_s motorId;
+
+//Test levels & results (phase A: mA, spins: sums over MOTOR_ID_SPIN_AVG_MS)
+static int16_t dutyHi = 0, dutyLo = 0;
+static uint8_t aligned = 0;
+static int32_t iHi = 0, iLo = 0;
+static int32_t wSum[2], iSum[2], jW = 0, jI = 0;
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static void motor_id_hold(int16_t duty);
+static int32_t motor_id_mean(void);
+static uint8_t motor_id_electrical(void);
+static uint8_t motor_id_mechanical(void);
+static void motor_id_ff(void);
+#ifdef USE_EEPROM
+static void motor_id_save(void);
+static void motor_id_load(void);
+#endif	//USE_EEPROM
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+void init_motor_id(void)
+{
+	memset(&motorId, 0, sizeof(motorId));
+	motorId.rFF = MOTOR_ID_R_FF_DEFAULT;
+	motorId.bemfFF = MOTOR_ID_BEMF_FF_DEFAULT;
+	motorId.lFF = MOTOR_ID_L_FF_DEFAULT;
+
+	//Results from a previous identification:
+	#ifdef USE_EEPROM
+	init_eeprom();
+	motor_id_load();
+	#endif	//USE_EEPROM
+}
+
+//Run at 1kHz while CALIBRATION_MOTOR_ID is set (the controllers are off).
+//1) Locked rotor: DC on phase A, high then low level (R), then a step back
+//to the high level sampled at the PWM rate (L). 2) Free rotor: two voltages
+//with the sine commutation (Ke), inertia from the acceleration between
+//them. The rotor must be free to spin. Returns 0 when done.
+uint8_t motor_id_calibration(void)
+{
+	static uint16_t t = 0, elapsed = 0;
+	int32_t w = 0, i = 0;
+	uint8_t fail = 0;
+
+	t++;
+	elapsed++;
+	switch(motorId.state)
+	{
+		case MOTOR_ID_IDLE:
+			motorId.aborted = 0;
+			motorId.valid = 0;
+			motorId.stepIdx = MOTOR_ID_STEP_SAMPLES;
+			dutyHi = 0;
+			dutyLo = 0;
+			aligned = 0;
+			motor_id_hold(0);
+			t = 0;
+			elapsed = 0;
+			motorId.state = MOTOR_ID_WAIT;
+			break;
+		case MOTOR_ID_WAIT:
+			if(t >= MOTOR_ID_REST_MS)
+			{
+				t = 0;
+				motorId.acc = 1;
+				motorId.state = MOTOR_ID_ALIGN;
+			}
+			break;
+		case MOTOR_ID_ALIGN:
+			//Raise the duty until enough current flows, then let the rotor settle:
+			if(!aligned && (t % MOTOR_ID_ALIGN_STEP_MS) == 0)
+			{
+				if(motor_id_mean() >= MOTOR_ID_ALIGN_MA)
+				{
+					dutyLo = dutyHi / 3;
+					aligned = 1;
+					t = 0;
+				}
+				else if(dutyHi >= MOTOR_ID_DUTY_MAX)
+				{
+					fail = 1;
+				}
+				else
+				{
+					motor_id_hold(++dutyHi);
+				}
+				motorId.acc = 1;
+			}
+			else if(aligned && t >= MOTOR_ID_ALIGN_MS)
+			{
+				t = 0;
+				motorId.state = MOTOR_ID_R_HI;
+			}
+			break;
+		case MOTOR_ID_R_HI:
+		case MOTOR_ID_R_LO:
+			if(as5047.signed_ang_vel > MOTOR_ID_LOCKED_CPMS || as5047.signed_ang_vel < -MOTOR_ID_LOCKED_CPMS)
+			{
+				fail = 1;
+			}
+			else if(t == MOTOR_ID_R_SETTLE_MS)
+			{
+				motor_id_mean();
+				motorId.acc = 1;
+			}
+			else if(t >= MOTOR_ID_R_SETTLE_MS + MOTOR_ID_R_AVG_MS)
+			{
+				t = 0;
+				if(motorId.state == MOTOR_ID_R_HI)
+				{
+					iHi = motor_id_mean();
+					motor_id_hold(dutyLo);
+					motorId.state = MOTOR_ID_R_LO;
+				}
+				else
+				{
+					iLo = motor_id_mean();
+					motorId.stepIdx = 0;
+					motor_id_hold(dutyHi);
+					motorId.state = MOTOR_ID_STEP;
+				}
+			}
+			break;
+		case MOTOR_ID_STEP:
+			if(motorId.stepIdx >= MOTOR_ID_STEP_SAMPLES)
+			{
+				motorId.hold = 0;
+				if(!motor_id_electrical())
+				{
+					fail = 1;
+					break;
+				}
+				t = 0;
+				wSum[0] = 0;
+				iSum[0] = 0;
+				setMotorVoltage(MOTOR_ID_SPIN_MV_1, 0);
+				motorId.state = MOTOR_ID_SPIN_1;
+			}
+			break;
+		case MOTOR_ID_SPIN_1:
+		case MOTOR_ID_SPIN_2:
+			w = as5047.signed_ang_vel;
+			i = ctrl[0].current.actual_val;
+			if(motorId.state == MOTOR_ID_SPIN_2 && t <= MOTOR_ID_J_MS)
+			{
+				jW += w;
+				jI += i;
+			}
+			if(t > MOTOR_ID_SPIN_SETTLE_MS)
+			{
+				wSum[motorId.state - MOTOR_ID_SPIN_1] += w;
+				iSum[motorId.state - MOTOR_ID_SPIN_1] += i;
+			}
+			if(t >= MOTOR_ID_SPIN_SETTLE_MS + MOTOR_ID_SPIN_AVG_MS)
+			{
+				t = 0;
+				if(motorId.state == MOTOR_ID_SPIN_1)
+				{
+					wSum[1] = 0;
+					iSum[1] = 0;
+					jW = 0;
+					jI = 0;
+					setMotorVoltage(MOTOR_ID_SPIN_MV_2, 0);
+					motorId.state = MOTOR_ID_SPIN_2;
+				}
+				else
+				{
+					motorId.state = MOTOR_ID_DONE;
+				}
+			}
+			break;
+		default:
+			setMotorVoltage(0, 0);
+			if(!motor_id_mechanical())
+			{
+				fail = 1;
+				break;
+			}
+			motor_id_ff();
+			#ifdef USE_EEPROM
+			motor_id_save();
+			#endif	//USE_EEPROM
+			motorId.state = MOTOR_ID_IDLE;
+			return 0;
+	}
+
+	//Test that couldn't complete, motor off:
+	if(fail || elapsed >= MOTOR_ID_TIMEOUT_MS)
+	{
+		motorId.aborted = motorId.state;
+		motorId.hold = 0;
+		motorId.acc = 0;
+		motorId.state = MOTOR_ID_IDLE;
+		setMotorVoltage(0, 0);
+		return 0;
+	}
+
+	return 1;
+}
+
+//SPI ISR, instead of the commutation while motorId.hold is set
+void motor_id_isr(void)
+{
+	int32_t ia = 0;
+
+	if(criticalError(0) || suppressMotor)
+	{
+		setDmaPwmCompare(PWM_AMP, PWM_AMP, PWM_AMP);
+	}
+	else
+	{
+		setDmaPwmCompare(PWM_AMP + motorId.duty, PWM_AMP, PWM_AMP);
+	}
+
+	//Phase A current, same scale & sign as foc_current_loop():
+	ia = -MOTOR_ID_MA_PER_LSB * (adc_dma_array[1] - phase_a_zero);
+	if(motorId.acc)
+	{
+		motorId.iSum += ia;
+		motorId.iCnt++;
+	}
+	if(motorId.stepIdx < MOTOR_ID_STEP_SAMPLES)
+	{
+		motorId.step[motorId.stepIdx++] = (int16_t)ia;
+	}
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+static void motor_id_hold(int16_t duty)
+{
+	motorId.duty = duty;
+	motorId.hold = 1;
+}
+
+//Mean phase A current since the last call, restarts the accumulation
+static int32_t motor_id_mean(void)
+{
+	int32_t sum = 0;
+	uint16_t cnt = 0;
+
+	motorId.acc = 0;
+	sum = motorId.iSum;
+	cnt = motorId.iCnt;
+	motorId.iSum = 0;
+	motorId.iCnt = 0;
+
+	return cnt ? (sum / cnt) : 0;
+}
+
+//R from the two DC levels, L from the step: with dV constant between samples
+//k1 & k2, dV x t = R x integral(i - iLo) + L x (i2 - i1). Offsets (dead
+//time, sensor) cancel in the differences.
+static uint8_t motor_id_electrical(void)
+{
+	int64_t dv = 0, s = 0, flux = 0;
+	int32_t di = 0, vb = 0;
+	uint16_t k = 0;
+	uint8_t inRange = 0;
+	const uint16_t k1 = MOTOR_ID_STEP_FIRST, k2 = MOTOR_ID_STEP_SAMPLES - 1;
+
+	vb = getDrooplessBatteryVoltage(&inRange);
+	if(!inRange || iHi - iLo <= 0)
+	{
+		return 0;
+	}
+
+	//Phase A, neutral referenced: 2/3 of the pole voltage. uV:
+	dv = ((int64_t)2000 * vb * (dutyHi - dutyLo)) / (3 * PWM_MAX);
+	motorId.r = (int32_t)(dv / (iHi - iLo));
+
+	//Trapezoid, mA x us. uV x us = pWb, L x mA = nWb:
+	for(k = k1; k <= k2; k++)
+	{
+		s += motorId.step[k] - iLo;
+	}
+	s -= ((motorId.step[k1] - iLo) + (motorId.step[k2] - iLo)) / 2;
+	s *= PWM_PERIOD_US;
+	di = motorId.step[k2] - motorId.step[k1];
+	if(di > MOTOR_ID_L_MIN_MA)
+	{
+		flux = dv * (k2 - k1) * PWM_PERIOD_US - (int64_t)motorId.r * s;
+		motorId.l = (int32_t)(flux / (1000 * (int64_t)di));
+	}
+
+	return (motorId.r > 0 && motorId.l >= 0);
+}
+
+//Steady state at 2 speeds: V = R x i + Ke x w, Ke x i = Tc + b x w. The
+//difference removes the constant voltage losses. Inertia: torque integral
+//over MOTOR_ID_J_MS, minus friction, over the speed change. The friction
+//(Tc, b) is only used for J: b x dw is a few mA of current.actual_val, within
+//its error (sim: b +90%), so neither is kept as a result.
+static uint8_t motor_id_mechanical(void)
+{
+	int64_t dw = 0, di = 0, dv = 0, tq = 0;
+	int32_t tc = 0, b = 0;
+	const int64_t n = MOTOR_ID_SPIN_AVG_MS;
+
+	dw = wSum[1] - wSum[0];
+	di = iSum[1] - iSum[0];
+	if(wSum[0] < MOTOR_ID_MIN_CPMS * n || dw < MOTOR_ID_MIN_CPMS * n)
+	{
+		return 0;
+	}
+
+	//Phase peak, uV x n (i = 3/2 peak):
+	dv = ((MOTOR_ID_SPIN_MV_2 - MOTOR_ID_SPIN_MV_1) * n * MOTOR_ID_CMD_NUM * 1000) / MOTOR_ID_CMD_DEN;
+	dv -= (motorId.r * di * 2) / 3;
+	motorId.ke = (int32_t)((dv * 1000000) / (dw * MOTOR_ID_CPMS_MRADS_K));
+
+	//Friction, uNm & nNm/(rad/s): torque (uNm) = Ke x i / 1000
+	b = (int32_t)(((int64_t)motorId.ke * di * 1000000) / (dw * MOTOR_ID_CPMS_MRADS_K));
+	tc = (int32_t)(((int64_t)motorId.ke * iSum[0]) / (n * 1000) - \
+		((int64_t)b * wSum[0] * MOTOR_ID_CPMS_MRADS_K) / (n * 1000000000));
+
+	//Inertia, uNm x ms over rad/s:
+	tq = ((int64_t)motorId.ke * jI) / 1000 - (int64_t)tc * MOTOR_ID_J_MS - \
+		((int64_t)b * jW * MOTOR_ID_CPMS_MRADS_K) / 1000000000;
+	motorId.j = (int32_t)((tq * n * 1000000) / ((wSum[1] - wSum[0]) * MOTOR_ID_CPMS_MRADS_K));
+	if(motorId.ke <= 0 || motorId.j <= 0)
+	{
+		return 0;
+	}
+
+	motorId.valid = 1;
+	return 1;
+}
+
+static void motor_id_ff(void)
+{
+	motorId.rFF = MOTOR_ID_R_FF(motorId.r);
+	motorId.bemfFF = (MOTOR_ID_BEMF_FF(motorId.ke) * MOTOR_ID_BEMF_FF_PCT) / 100;
+	if(motorId.l)
+	{
+		motorId.lFF = MOTOR_ID_L_FF(motorId.l);
+	}
+}
+
+#ifdef USE_EEPROM
+
+static void motor_id_save(void)
+{
+	uint16_t buf[MOTOR_ID_EE_WORDS];
+	int32_t *p[MOTOR_ID_PARAMS] = MOTOR_ID_PARAM_PTRS;
+	uint8_t i = 0;
+
+	memset(buf, 0, sizeof(buf));
+	for(i = 0; i < MOTOR_ID_PARAMS; i++)
+	{
+		buf[2 * i] = (uint16_t)(*p[i] >> 16);
+		buf[2 * i + 1] = (uint16_t)*p[i];
+	}
+	buf[2 * MOTOR_ID_PARAMS] = MOTOR_ID_MAGIC;
+
+	save_angles_to_eeprom(buf, MOTOR_ID);
+}
+
+static void motor_id_load(void)
+{
+	uint16_t buf[MOTOR_ID_EE_WORDS];
+	int32_t *p[MOTOR_ID_PARAMS] = MOTOR_ID_PARAM_PTRS;
+	uint8_t i = 0;
+
+	load_angles_from_eeprom(buf, MOTOR_ID);
+
+	//Never identified:
+	if(buf[2 * MOTOR_ID_PARAMS] != MOTOR_ID_MAGIC)
+	{
+		return;
+	}
+
+	for(i = 0; i < MOTOR_ID_PARAMS; i++)
+	{
+		*p[i] = (int32_t)(((uint32_t)buf[2 * i] << 16) | buf[2 * i + 1]);
+	}
+	motorId.valid = 1;
+	motor_id_ff();
+}
+
+#endif	//USE_EEPROM
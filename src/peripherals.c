@@ -82,11 +82,6 @@ void init_peripherals(void)
 	//Timebases:
 	init_tb_timers();
 	
-	#if(MOTOR_COMMUT == COMMUT_SINE) 
-	//Angle read timer
-	init_angle_timer();
-	#endif //(MOTOR_COMMUT == COMMUT_SINE) 
-
 	//UART 2 - RS-485
 	init_rs485();
 	
@@ -175,6 +170,7 @@ void init_peripherals(void)
 	
 		//Initialize structures:
 		init_as504x(&as5047);
+		init_as5047_vel();
 	
 	#endif	//(MOTOR_COMMUT == COMMUT_SINE) 
 }
@@ -0,0 +1,98 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-execute' Advanced Motion Controller
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] ringbuf: ring buffers with O(1) windowed mean & slope
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-17 | agent | Initial release
+	*
+****************************************************************************/
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include "main.h"
+#include "ringbuf.h"
+#include <string.h>
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+//'window' samples are used by ringbuf_mean() & ringbuf_slope() (1 to
+//RINGBUF_LEN). Starts full of zeros.
+void ringbuf_init(struct ringbuf_s *rb, uint8_t window)
+{
+	int32_t n = 0;
+
+	if(window < 1) {window = 1;}
+	if(window > RINGBUF_LEN) {window = RINGBUF_LEN;}
+
+	memset(rb->buf, 0, sizeof(rb->buf));
+	rb->sum = 0;
+	rb->ageSum = 0;
+	rb->idx = 0;
+	rb->window = window;
+
+	n = window;
+	rb->slopeDen = (n > 1) ? ((n * (n * n - 1)) / 6) : 1;
+}
+
+//O(1): every sample ages by 1, the oldest one leaves the window
+void ringbuf_push(struct ringbuf_s *rb, int32_t x)
+{
+	uint32_t old = (uint32_t)rb->buf[(rb->idx - (rb->window - 1)) & RINGBUF_MASK];
+
+	rb->ageSum += rb->sum - rb->window * old;
+	rb->sum += (uint32_t)x - old;
+	rb->idx = (rb->idx + 1) & RINGBUF_MASK;
+	rb->buf[rb->idx] = x;
+}
+
+//age = 0 for the newest sample, up to RINGBUF_LEN - 1
+int32_t ringbuf_get(struct ringbuf_s *rb, uint8_t age)
+{
+	return rb->buf[(rb->idx - age) & RINGBUF_MASK];
+}
+
+//Newest sample minus the one 'lag' samples before
+int32_t ringbuf_diff(struct ringbuf_s *rb, uint8_t lag)
+{
+	return ringbuf_get(rb, 0) - ringbuf_get(rb, lag);
+}
+
+int32_t ringbuf_mean(struct ringbuf_s *rb)
+{
+	return (int32_t)rb->sum / rb->window;
+}
+
+//Least squares slope over the window, x 'scale', per sample. With a 5
+//samples window and scale = 1, same as get_vel_1k_5samples() / 1000.
+int32_t ringbuf_slope(struct ringbuf_s *rb, int32_t scale)
+{
+	//(N-1)*sum - 2*ageSum = 2*sum((t - t_mean)*x), exact modulo 2^32
+	int32_t num = (int32_t)((rb->window - 1) * rb->sum - 2 * rb->ageSum);
+
+	return (int32_t)(((int64_t)num * scale) / rb->slopeDen);
+}
@@ -42,6 +42,10 @@
 #include "control.h"
 #include "flexsea_user_structs.h"
 #include "main_fsm.h"
+#include "fixed_math.h"
+#include "ringbuf.h"
+#include "motor_id.h"
+#include "calibration_tools.h"
 
 //****************************************************************************
 // Variable(s)
@@ -55,17 +59,17 @@ uint8_t measure_motor_resistance = 0;
 int i2t_flag = 0;
 volatile uint8_t badFindPoles = 0;
 
-int16_t phaseAcoms[2048];
-int16_t phaseBcoms[2048];
-int16_t phaseCcoms[2048];
+//Electrical angle of phase A (16 bits = 360deg) for each 8-count encoder
+//bin. B & C are 120/240deg shifts, sin/cos come from the Flash table.
+uint16 commElecAng[2048];
 
 int32_t PWM_A_Value;
 int32_t PWM_B_Value;
 int32_t PWM_C_Value;
 
-int16 phaseAcoscoms[2048];
-int16 phaseBcoscoms[2048];
-int16 phaseCcoscoms[2048];
+//Modulation, can be changed at runtime:
+volatile uint8_t pwmModulation = PWM_MODULATION;
+volatile struct mod_test_s modTest[3];
 
 //****************************************************************************
 // Private Function Prototype(s):
@@ -77,34 +81,6 @@ static void arePolesGood(void);
 // Public Function(s)
 //****************************************************************************
 
-int get_sin_profile(double t, double period)
-{
-	static double sin_amp = PWM_AMP;
-	static double fund_freq;
-
-	fund_freq = round(sin_amp*sin(t*6.2832/period));
-	
-	return fund_freq;//+sin_amp;
-	
-	//Use the below if you would like 3rd order harmonic injection, but the 
-	//current signal will become very noisy
-	//static double third_freq;
-	//static double sum_freq;
-	//third_freq = sin_amp/6.0*sin(3*t*6.2832/period);
-	//sum_freq = (fund_freq+third_freq)/0.8662;
-	//return (int)sum_freq+sin_amp;
-}
-
-int get_cos_profile(double t, double period)
-{
-	static double cos_amp = 1024;
-	static double fund_freq;
-
-	fund_freq = round(cos_amp*cos(t*6.2832/period));
-	
-	return fund_freq;//+sin_amp;
-}
-
 //run at 1 kHz
 void find_poles(void)
 {
@@ -237,28 +213,23 @@ void find_poles(void)
 
 void load_eeprom_to_angles(void)
 {
-	static int16_t outs1[6] = {0,0,0,0,0,0};
-	static int16_t outs2[6] = {0,0,0,0,0,0};
+	uint16 e1 = 0, e2 = 0;
 	load_angles_from_eeprom(anglemap, COMMUTATION);
 	initpole = anglemap[126];
 	
 	int16 ii = 3;
 	while(ii<=MAX_ENC)
 	{
-		fill_comm_tables(ii,outs1);
-		fill_comm_tables(ii+1,outs2);
-		phaseAcoms[ii>>3] = (outs1[0]+outs2[0])/2;
-		phaseBcoms[ii>>3] = (outs1[1]+outs2[1])/2;
-		phaseCcoms[ii>>3] = (outs1[2]+outs2[2])/2;  
-		phaseAcoscoms[ii>>3] = (outs1[3]+outs2[3])/2;
-		phaseBcoscoms[ii>>3] = (outs1[4]+outs2[4])/2;
-		phaseCcoscoms[ii>>3] = (outs1[5]+outs2[5])/2;
+		//Middle of [ii, ii+1] (the difference is signed to survive a wrap)
+		e1 = get_comm_elec_angle(ii);
+		e2 = get_comm_elec_angle(ii+1);
+		commElecAng[ii>>3] = e1 + ((int16)(e2-e1))/2;
 		ii += 8;
 	}
 }
 
-//ang goes from 0 to 16384
-void fill_comm_tables(int32 ang, int16_t * outs)
+//ang goes from 0 to 16384. Returns the electrical angle of phase A.
+uint16 get_comm_elec_angle(int32 ang)
 {
 	volatile int32 period = 0, rel_ang;
 	int32 six_period = 0;
@@ -312,12 +283,7 @@ void fill_comm_tables(int32 ang, int16_t * outs)
 	}
 	six_period = period*6;
 	
-	outs[0] = (get_sin_profile((rel_ang),six_period));
-	outs[1] = (get_sin_profile((rel_ang+period*2),six_period));
-	outs[2] = (get_sin_profile((rel_ang+period*4),six_period));
-	outs[3] = (get_cos_profile((rel_ang),six_period));
-	outs[4] = (get_cos_profile((rel_ang+period*2),six_period));
-	outs[5] = (get_cos_profile((rel_ang+period*4),six_period));
+	return ratio_to_ang16(rel_ang, six_period);
 }
 
 static void arePolesGood(void)
@@ -384,10 +350,12 @@ void sensor_sin_commut(int16 ang, int32 pwm)
 			//at 0 pwm = 1980/2000
 			//at 990 pwm = 0/2000
 
-			PWM_A_Value=((((int32)(phaseAcoms[ang])*pwm)+induc_amp*(int32_t)phaseAcoscoms[ang])/1024+PWM_AMP);
-			PWM_B_Value=((((int32)(phaseBcoms[ang])*pwm)+induc_amp*(int32_t)phaseBcoscoms[ang])/1024+PWM_AMP);
-			PWM_C_Value=((((int32)(phaseCcoms[ang])*pwm)+induc_amp*(int32_t)phaseCcoscoms[ang])/1024+PWM_AMP);
+			int32 duty[3];
 			
+			comm_duty_cycles(commElecAng[ang], pwm, induc_amp, duty);
+			PWM_A_Value = duty[0];
+			PWM_B_Value = duty[1];
+			PWM_C_Value = duty[2];
 		}		
 		
 		if (PWM_A_Value>989) {PWM_A_Value = 989;}
@@ -410,26 +378,162 @@ void sensor_sin_commut(int16 ang, int32 pwm)
 	#endif
 }
 
+//Duty cycles (not clipped) for an electrical angle 'e', with 'pwm' on the
+//sin() axis and 'ind' on the cos() axis (+/-1024 = +/-PWM_AMP for MOD_SINE)
+void comm_duty_cycles(uint16 e, int32 pwm, int32 ind, int32 *duty)
+{
+	int32 m2 = 0, mq = 0, md = 0;
+	
+	duty[0] = ((COMM_SIN(e)*pwm)+ind*COMM_COS(e))/1024;
+	duty[1] = ((COMM_SIN(e+COMM_PHASE_B)*pwm)+ind*COMM_COS(e+COMM_PHASE_B))/1024;
+	duty[2] = ((COMM_SIN(e+COMM_PHASE_C)*pwm)+ind*COMM_COS(e+COMM_PHASE_C))/1024;
+	
+	if(pwmModulation == MOD_THI)
+	{
+		mq = (pwm*PWM_AMP)>>10;
+		md = (ind*PWM_AMP)>>10;
+		m2 = mq*mq + md*md;
+	}
+	pwm_modulate(duty, m2);
+	
+	duty[0] += PWM_AMP;
+	duty[1] += PWM_AMP;
+	duty[2] += PWM_AMP;
+}
+
+//Adds the zero sequence voltage of the active modulation to 3 phase values
+//centered on 0 (PWM counts). The line-to-line voltages are not changed.
+//'m2' is the squared amplitude of the phase voltages, only used by MOD_THI.
+void pwm_modulate(int32 *v, int32 m2)
+{
+	static int32 thiM2 = 0;
+	static int64_t thiRecip = 0;
+	int32 offset = 0, vMin = 0, vMax = 0, r = 0;
+	int64_t v2 = 0;
+	uint8 i = 0;
+	
+	if(pwmModulation == MOD_SVPWM)
+	{
+		//Centers the 3 phases: -(min+max)/2
+		vMin = v[0];
+		vMax = v[0];
+		for(i = 1; i < 3; i++)
+		{
+			if(v[i] < vMin) {vMin = v[i];}
+			if(v[i] > vMax) {vMax = v[i];}
+		}
+		offset = -((vMin + vMax) >> 1);
+	}
+	else if(pwmModulation == MOD_THI && m2 > 0)
+	{
+		//M/6*sin(3x), from phase A: sin(3x) = 3sin(x) - 4sin(x)^3
+		//=> offset = v/2 - (2/3)*v^3/M^2. r = (v/M)^2, Q10. 1/M^2 (Q40)
+		//only changes with the amplitude, the ISR doesn't divide.
+		if(m2 != thiM2)
+		{
+			thiRecip = ((int64_t)1 << 40) / m2;
+			thiM2 = m2;
+		}
+		v2 = (int64_t)v[0] * v[0];
+		r = (v2 >= m2) ? 1024 : (int32)((v2 * thiRecip) >> 30);
+		offset = (v[0]>>1) - (int32)(((int64_t)v[0] * r * THI_DIV_1536) >> 26);
+	}
+	
+	v[0] += offset;
+	v[1] += offset;
+	v[2] += offset;
+}
+
 //****************************************************************************
 // Private Function(s)
 //****************************************************************************
 
 void calc_motor_L(void)
 {
-	static struct diffarr_s currs;
-	static int32_t mot_induc;
+	static struct ringbuf_s currs;
+	static int32_t mot_induc, currsAvg;
 	
-	update_diffarr(&currs,ctrl[0].current.actual_vals.avg,20);
-	update_diffarr_avg(&currs,10);
-	if (ctrl[0].active_ctrl == CTRL_NONE)
+	if(!currs.window)
+	{
+		ringbuf_init(&currs, 10);
+	}
+	ringbuf_push(&currs, ctrl[0].current.actual_vals.avg);
+	currsAvg = ringbuf_mean(&currs);
+	if (ctrl[0].active_ctrl == CTRL_NONE || calibrationFlags)
 	{
 		mot_induc = 0;
 	}
 	else
 	{
-		mot_induc = 70;
+		mot_induc = motorId.lFF;
 	}
 	globvar[0] = as5047.signed_ang_vel;
-	globvar[1] = currs.avg;
-	induc_amp = ((mot_induc*(as5047.signed_ang_vel)*currs.avg)/safety_cop.v_vb_mv)/149;
+	globvar[1] = currsAvg;
+	induc_amp = ((mot_induc*(as5047.signed_ang_vel)*currsAvg)/safety_cop.v_vb_mv)/149;
 }	
+
+//****************************************************************************
+// Test Function(s) - Use with care!
+//****************************************************************************
+
+//Compares the 3 modulations: largest amplitude before clipping, peak
+//line-to-line voltage (per mil of the bus) and line-to-line THD at an
+//amplitude of MOD_TEST_AMP. Uses doubles, runs on the host simulation too.
+//Results in modTest[MOD_SINE..MOD_THI].
+void modulation_test(void)
+{
+	uint8 mode = 0, clipped = 0;
+	uint16 k = 0;
+	int32 amp = 0, duty[3], vll = 0, vllPeak = 0;
+	double sum = 0.0, sum2 = 0.0, a1 = 0.0, b1 = 0.0, th = 0.0, fund2 = 0.0;
+	uint8 oldMod = pwmModulation;
+	
+	for(mode = MOD_SINE; mode <= MOD_THI; mode++)
+	{
+		pwmModulation = mode;
+		
+		//Linear range:
+		for(amp = 900, clipped = 0; !clipped; amp++)
+		{
+			vllPeak = 0;
+			for(k = 0; k < MOD_TEST_POINTS; k++)
+			{
+				comm_duty_cycles(k * (65536 / MOD_TEST_POINTS), amp, 0, duty);
+				if(duty[0] < 1 || duty[0] > 989 || duty[1] < 1 || duty[1] > 989 || \
+					duty[2] < 1 || duty[2] > 989)
+				{
+					clipped = 1;
+					break;
+				}
+				vll = (duty[0] > duty[1]) ? (duty[0] - duty[1]) : (duty[1] - duty[0]);
+				if(vll > vllPeak) {vllPeak = vll;}
+			}
+			if(!clipped)
+			{
+				modTest[mode].maxAmp = amp;
+				modTest[mode].vllPerMil = (vllPeak * 1000) / PWM_MAX;
+			}
+		}
+		
+		//THD of Vab, with the 1..989 clipping:
+		sum = 0.0; sum2 = 0.0; a1 = 0.0; b1 = 0.0;
+		for(k = 0; k < MOD_TEST_POINTS; k++)
+		{
+			comm_duty_cycles(k * (65536 / MOD_TEST_POINTS), MOD_TEST_AMP, 0, duty);
+			duty[0] = (duty[0] > 989) ? 989 : ((duty[0] < 1) ? 1 : duty[0]);
+			duty[1] = (duty[1] > 989) ? 989 : ((duty[1] < 1) ? 1 : duty[1]);
+			vll = duty[0] - duty[1];
+			th = 6.283185307179586 * k / MOD_TEST_POINTS;
+			sum += vll;
+			sum2 += (double)vll * vll;
+			a1 += vll * sin(th);
+			b1 += vll * cos(th);
+		}
+		sum /= MOD_TEST_POINTS;
+		sum2 = sum2 / MOD_TEST_POINTS - sum * sum;		//AC power
+		fund2 = 2.0 * (a1 * a1 + b1 * b1) / ((double)MOD_TEST_POINTS * MOD_TEST_POINTS);
+		modTest[mode].thdPerMil = (int32)(1000.0 * sqrt((sum2 > fund2) ? (sum2 - fund2) / fund2 : 0.0));
+	}
+	
+	pwmModulation = oldMod;
+}
@@ -38,16 +38,17 @@
 #include "misc.h"
 #include "flexsea_comm.h"
 #include "user-ex.h"
+#include "fsm_timing.h"
 
 //****************************************************************************
 // Variable(s)
 //****************************************************************************
 
-uint8_t uart_dma_rx_buf[96];	//ToDo #define
-uint8_t uart_dma_rx_buf_unwrapped[96];
-uint8_t uart_dma_tx_buf[96];
-uint8_t uart_dma_bt_rx_buf[96];
-uint8_t uart_dma_bt_rx_buf_unwrapped[96];
+uint8_t uart_dma_rx_buf[UART_DMA_BUF_LEN];
+uint8_t uart_dma_rx_buf_unwrapped[UART_DMA_BUF_LEN];
+uint8_t uart_dma_tx_buf[UART_DMA_BUF_LEN];
+uint8_t uart_dma_bt_rx_buf[UART_DMA_BUF_LEN];
+uint8_t uart_dma_bt_rx_buf_unwrapped[UART_DMA_BUF_LEN];
 volatile int8_t tx_cnt = 0;
 uint8_t uart_tmp_buf[RX_BUF_LEN];
 
@@ -61,42 +62,60 @@ uint8_t DMA_6_TD[1];
 uint8_t DMA_7_Chan;
 uint8_t DMA_7_TD[1];
 
+//RS-485 RX, positions in the DMA pass (0-RS485_RX_TD_LEN):
+static volatile uint8_t rxFlushed = 0;		//Next byte for the parser
+static volatile uint8_t rxLastPos = 0;
+static uint8_t rxIdle = 0;
+
+//RS-485 TX:
+volatile uint8_t rs485TxState = RS485_TX_IDLE;
+static uint16 t2Setup = 0, t2Turnaround = 0;
+uint32_t rs485BenchCycles = 0, rs485BenchLegacyCycles = 0;
+
+//Replies:
+static struct rs485_reply_s replyQueue[RS485_REPLY_QUEUE_LEN];
+static uint8_t replyHead = 0, replyTail = 0;
+uint32_t rs485ReplyDelayUs = RS485_REPLY_DELAY_US;
+uint16_t rs485ReplyDropped = 0;
+
 //****************************************************************************
 // Private Function Prototype(s):
 //****************************************************************************
 
 static void init_dma_3(void);	//RS-485 RX
 static void init_dma_4(void);	//RS-485 TX
+static void rs485_puts_busywait(uint8_t *buf, uint32 len);
 static void init_dma_6(void);	//Bluetooth RX
+static uint8_t rs485_rx_dma_pos(void);
+static void rs485_rx_flush(uint8_t pos);
 
 //****************************************************************************
 // Public Function(s)
 //****************************************************************************
 
-//Transmit serial data with DMA
-//The DMA transfer is for 48 bytes, by configuration. ToDo: this isn't clean
+//Transmit serial data with DMA, 'len' bytes (COMM_STR_BUF_LEN if 0). Doesn't
+//wait: Timer_2 starts the DMA once the transceiver is switched, see
+//rs485_t2_isr().
 void rs485_puts(uint8_t *buf, uint32 len)
 {
-	(void)len; //Unused for now
+	if(len == 0) {len = COMM_STR_BUF_LEN;}
+	if(len > UART_DMA_BUF_LEN) {len = UART_DMA_BUF_LEN;}
 	
 	UART_DMA_XMIT_Write(0);		//No transmission
 	UART_2_ClearTxBuffer();		//Clear any old data
 	
-	CyDelayUs(1);
-	NOT_RE_Write(1);			//Disable Receiver
-	CyDelayUs(1);
-	DE_Write(1);				//Enable Receiver
-	CyDelayUs(1);
-	//Note: these small delays matter, keep them
-	
-	//Copy the bytes:
-	memcpy(uart_dma_tx_buf, buf, COMM_STR_BUF_LEN);
-	
-	//Enable channel and UART TX ISR line:
-	CyDmaChEnable(DMA_4_Chan, 1);
-	UART_DMA_XMIT_Write(1);		//Allow transmission
+	//Copy the bytes, TD length:
+	memcpy(uart_dma_tx_buf, buf, len);
+	CyDmaTdSetConfiguration(DMA_4_TD[0], (uint16)len, CY_DMA_DISABLE_TD, RS485_TX_TD_CONFIG);
 	
-	//DMA will take it from here, go to CY_ISR(isr_dma_uart_tx_Interrupt) for the end
+	//Transceiver in TX mode. The driver needs a few us (RS485_SETUP_US)
+	//before the first byte.
+	rs485TxState = RS485_TX_SETUP;
+	NOT_RE_Write(1);			//Disable Receiver
+	DE_Write(1);				//Enable Emitter
+	Timer_2_WritePeriod(t2Setup);
+	T2_RESET_Write(0);
+	Timer_2_Start();
 }
 
 //Sends a single character to the UART
@@ -127,8 +146,10 @@ void init_rs485(void)
 	isr_dma_uart_tx_Start();
 	NOT_RE_Write(0);			//Enable RS-485 Receiver
 	
-	//Timer 2: 10us (2 bytes)
+	//Timer 2: 10us (2 bytes) turnaround, RS485_SETUP_US before sending
 	Timer_2_Init();
+	t2Turnaround = Timer_2_ReadPeriod();
+	t2Setup = (t2Turnaround * RS485_SETUP_US) / 10;
 	Timer_2_Start();
 	isr_t2_Start();
 	
@@ -150,16 +171,119 @@ void init_bluetooth(void)
 }
 
 //We have a packet ready, but we want to wait a little while before sending it
+//(rs485ReplyDelayUs after now, whatever the FSM slot). It's copied: the next
+//reply can be prepared right away.
 void rs485DelayedTransmit(PacketWrapper* p)
 {
+	struct rs485_reply_s *r;
+	uint8_t next = 0;
+	
 	if(p->destinationPort == PORT_RS485_1)
 	{
-		//packet[PORT_RS485_1][OUTBOUND] should already be filled
+		next = (replyHead + 1) & RS485_REPLY_QUEUE_MASK;
+		if(next == replyTail)
+		{
+			if(rs485ReplyDropped < UINT16_MAX) {rs485ReplyDropped++;}
+			return;
+		}
 		
-		commPeriph[PORT_RS485_1].tx.packetReady = 1;
-		//Get reply timestamp from main FSM:
-		commPeriph[PORT_RS485_1].tx.timeStamp = (t1_time_share + REPLY_DELAY) % 10;
+		r = &replyQueue[replyHead];
+		r->len = (p->numb) ? p->numb : COMM_STR_BUF_LEN;
+		if(r->len > UART_DMA_BUF_LEN) {r->len = UART_DMA_BUF_LEN;}
+		memcpy(r->buf, p->packed, r->len);
+		r->dueUs = fsmTimingNowUs() + rs485ReplyDelayUs;
+		replyHead = next;
+	}
+}
+
+//Call at 10kHz: sends the oldest reply once it's due and the bus is free
+void rs485_reply_service(void)
+{
+	struct rs485_reply_s *r;
+	
+	if((replyHead == replyTail) || (rs485TxState != RS485_TX_IDLE))
+	{
+		return;
+	}
+	
+	r = &replyQueue[replyTail];
+	if((int32_t)(fsmTimingNowUs() - r->dueUs) < 0)
+	{
+		return;
 	}
+	
+	rs485_puts(r->buf, r->len);
+	replyTail = (replyTail + 1) & RS485_REPLY_QUEUE_MASK;
+}
+
+//Call at 10kHz, before parsing. Short commands don't wait for the DMA
+//buffer to be full.
+void rs485_rx_poll(void)
+{
+	uint8_t pos = 0;
+	uint8 intState = 0;
+	
+	intState = CyEnterCriticalSection();
+	pos = rs485_rx_dma_pos();
+	
+	if(pos < rxLastPos)
+	{
+		//The TD wrapped, rs485_rx_dma_isr() will take care of it. At 2Mbps
+		//a pass takes 240us, we can't miss one.
+	}
+	else if(pos != rxLastPos)
+	{
+		rxLastPos = pos;
+		rxIdle = 0;
+	}
+	else if(pos > rxFlushed)
+	{
+		rxIdle++;
+		if(rxIdle >= RS485_RX_IDLE_TICKS)
+		{
+			rs485_rx_flush(pos);
+			rxIdle = 0;
+		}
+	}
+	
+	CyExitCriticalSection(intState);
+}
+
+//Timer_2 (one-shot): transceiver ready, or last byte sent
+void rs485_t2_isr(void)
+{
+	if(rs485TxState == RS485_TX_SETUP)
+	{
+		//Enable channel and UART TX ISR line, the DMA takes it from here
+		rs485TxState = RS485_TX_SENDING;
+		CyDmaChEnable(DMA_4_Chan, 1);
+		UART_DMA_XMIT_Write(1);
+	}
+	else
+	{
+		//Transfer is over, enable Receiver & disable Emitter
+		UART_DMA_XMIT_Write(0);		//No transmission
+		DE_Write(0);
+		NOT_RE_Write(0);
+		rs485TxState = RS485_TX_IDLE;
+	}
+}
+
+//TX DMA done: the UART still has to send its last bytes
+void rs485_tx_dma_isr(void)
+{
+	rs485TxState = RS485_TX_TURNAROUND;
+	Timer_2_WritePeriod(t2Turnaround);
+	T2_RESET_Write(0);
+	Timer_2_Start();
+}
+
+//End of a DMA pass (buffer full)
+void rs485_rx_dma_isr(void)
+{
+	rs485_rx_flush(RS485_RX_TD_LEN);
+	rxFlushed = 0;
+	rxLastPos = 0;
 }
 
 //****************************************************************************
@@ -195,6 +319,36 @@ void test_uart_dma_xmit(void)
 	}
 }
 
+//rs485_puts() execution time (what sendMasterDelayedResponse() costs the
+//10kHz slot), in rs485BenchCycles. Sends RS485_BENCH_N 48 bytes packets.
+//The previous busy-wait sequence is timed in the same run, for reference
+//(rs485BenchLegacyCycles).
+void rs485_tx_benchmark(void)
+{
+	uint8_t buf[48];
+	uint32_t t0 = 0, sum = 0, sumLegacy = 0;
+	uint16_t i = 0;
+	
+	memset(buf, 0xAA, sizeof(buf));
+	for(i = 0; i < RS485_BENCH_N; i++)
+	{
+		t0 = FSM_TIMING_NOW();
+		rs485_puts(buf, sizeof(buf));
+		sum += FSM_TIMING_NOW() - t0;
+		
+		//Let it go out (48 bytes: 240us)
+		CyDelayUs(300);
+		
+		t0 = FSM_TIMING_NOW();
+		rs485_puts_busywait(buf, sizeof(buf));
+		sumLegacy += FSM_TIMING_NOW() - t0;
+		CyDelayUs(300);
+	}
+	
+	rs485BenchCycles = sum / RS485_BENCH_N;
+	rs485BenchLegacyCycles = sumLegacy / RS485_BENCH_N;
+}
+
 //****************************************************************************
 // Private Function(s)
 //****************************************************************************
@@ -210,7 +364,7 @@ static void init_dma_3(void)
 	DMA_3_Chan = DMA_3_DmaInitialize(DMA_3_BYTES_PER_BURST, DMA_3_REQUEST_PER_BURST, 
 		HI16(DMA_3_SRC_BASE), HI16(DMA_3_DST_BASE));
 	DMA_3_TD[0] = CyDmaTdAllocate();
-	CyDmaTdSetConfiguration(DMA_3_TD[0], 48, DMA_3_TD[0], DMA_3__TD_TERMOUT_EN | TD_INC_DST_ADR);
+	CyDmaTdSetConfiguration(DMA_3_TD[0], RS485_RX_TD_LEN, DMA_3_TD[0], DMA_3__TD_TERMOUT_EN | TD_INC_DST_ADR);
 	CyDmaTdSetAddress(DMA_3_TD[0], LO16((uint32)UART_2_RXDATA_PTR), LO16((uint32)uart_dma_rx_buf));
 	CyDmaChSetInitialTd(DMA_3_Chan, DMA_3_TD[0]);
 	CyDmaChEnable(DMA_3_Chan, 1);
@@ -227,12 +381,34 @@ static void init_dma_4(void)
 	DMA_4_Chan = DMA_4_DmaInitialize(DMA_4_BYTES_PER_BURST, DMA_4_REQUEST_PER_BURST, 
 		HI16(DMA_4_SRC_BASE), HI16(DMA_4_DST_BASE));
 	DMA_4_TD[0] = CyDmaTdAllocate();
-	CyDmaTdSetConfiguration(DMA_4_TD[0], 48, CY_DMA_DISABLE_TD, TD_TERMIN_EN | DMA_4__TD_TERMOUT_EN | TD_INC_SRC_ADR | TD_AUTO_EXEC_NEXT);
+	CyDmaTdSetConfiguration(DMA_4_TD[0], COMM_STR_BUF_LEN, CY_DMA_DISABLE_TD, RS485_TX_TD_CONFIG);
 	CyDmaTdSetAddress(DMA_4_TD[0], LO16((uint32)uart_dma_tx_buf), LO16((uint32)UART_2_TXDATA_PTR));
 	CyDmaChSetInitialTd(DMA_4_Chan, DMA_4_TD[0]);
 	CyDmaChEnable(DMA_4_Chan, 1);
 }
 
+//rs485_puts() before Timer_2 sequencing (3 x 1us busy waits), for
+//rs485_tx_benchmark() only
+static void rs485_puts_busywait(uint8_t *buf, uint32 len)
+{
+	UART_DMA_XMIT_Write(0);		//No transmission
+	UART_2_ClearTxBuffer();		//Clear any old data
+	
+	CyDelayUs(1);
+	NOT_RE_Write(1);			//Disable Receiver
+	CyDelayUs(1);
+	DE_Write(1);				//Enable Emitter
+	CyDelayUs(1);
+	
+	memcpy(uart_dma_tx_buf, buf, len);
+	CyDmaTdSetConfiguration(DMA_4_TD[0], (uint16)len, CY_DMA_DISABLE_TD, RS485_TX_TD_CONFIG);
+	
+	//The TX DMA interrupt then releases the bus, as for rs485_puts()
+	rs485TxState = RS485_TX_SENDING;
+	CyDmaChEnable(DMA_4_Chan, 1);
+	UART_DMA_XMIT_Write(1);		//Allow transmission
+}
+
 //DMA6: UART RX (Bluetooth)
 static void init_dma_6(void)
 {
@@ -249,3 +425,33 @@ static void init_dma_6(void)
 	CyDmaChSetInitialTd(DMA_6_Chan, DMA_6_TD[0]);
 	CyDmaChEnable(DMA_6_Chan, 1);
 }
+
+//Bytes written by the RX DMA in the current pass. The channel is enabled with
+//preserveTds: the working copy of the TD is kept in TD memory at the index
+//of the channel, its count goes down as bytes come in.
+static uint8_t rs485_rx_dma_pos(void)
+{
+	uint16 count = 0;
+	uint8 nextTd = 0, config = 0;
+	
+	CyDmaTdGetConfiguration(DMA_3_Chan, &count, &nextTd, &config);
+	if((count == 0) || (count > RS485_RX_TD_LEN))
+	{
+		return 0;
+	}
+	
+	return (uint8_t)(RS485_RX_TD_LEN - count);
+}
+
+//Hands the new bytes [rxFlushed, pos) to the parser
+static void rs485_rx_flush(uint8_t pos)
+{
+	if(pos <= rxFlushed)
+	{
+		return;
+	}
+	
+	update_rx_buf_485(&uart_dma_rx_buf[rxFlushed], pos - rxFlushed);
+	commPeriph[PORT_RS485_1].rx.bytesReadyFlag++;
+	rxFlushed = pos;
+}
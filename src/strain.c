@@ -175,11 +175,25 @@ void strain_6ch_bytes_to_words(uint8_t *buf)
 	ext_strain[5] = ((((uint16)buf[10] << 8) & 0xFF00) | (uint16)buf[11]);
 }
 
-//Get latest readings from the 6-ch strain sensor. Using the Compressed version,
-//9bytes, 12-bits per sensor
+//Get latest readings from the 6-ch strain sensor (blocking). Using the
+//Compressed version, 9bytes, 12-bits per sensor
 void get_6ch_strain(void) 
 {	
-	i2c0_read(I2C_SLAVE_ADDR_6CH, MEM_R_CH1_H, ext_strain_bytes, 9);
+	if(i2c0_read(I2C_SLAVE_ADDR_6CH, MEM_R_CH1_H, ext_strain_bytes, 9) == I2C0_READ_OK)
+	{
+		strain_6ch_decode(ext_strain_bytes);
+	}
+}
+
+//I2C0 queue decoder (9 bytes), called from the ISR
+void strain_6ch_decode(uint8_t *buf)
+{
+	uint8_t i = 0;
+	
+	for(i = 0; i < 9; i++)
+	{
+		strain1.compressedBytes[i] = buf[i];
+	}
 }
 
 //Compress 6x uint16 to 9 bytes (12bits per sensor).
@@ -35,6 +35,7 @@
 
 #include "main.h"
 #include "ui.h"
+#include "i2c.h"
 #include "rgb_led.h"
 #include "user-ex.h"
 
@@ -63,10 +64,7 @@ void i2c_init_minm(uint8_t color)
 	minm_i2c_buf[1] = 0;
 	
 	//Stop script:
-	I2C_0_MasterClearStatus();
-	//I2C_0_MasterClearWriteBuf();
-    I2C_0_MasterWriteBuf(I2C_SLAVE_ADDR_MINM, (uint8_t *) minm_i2c_buf,
-                             4, I2C_0_MODE_COMPLETE_XFER);
+	i2c0_write(I2C_SLAVE_ADDR_MINM, minm_i2c_buf, 4);
 	
 	CyDelay(50);
 	
@@ -81,8 +79,8 @@ void i2c_init_minm(uint8_t color)
 	CyDelay(25);
 }
 
-//Write to MinM RGB LED
-void i2c_write_minm_rgb(uint8_t cmd, uint8_t r, uint8_t g, uint8_t b)
+//Write to MinM RGB LED. Returns 1 if the I2C0 queue couldn't take it.
+uint8_t i2c_write_minm_rgb(uint8_t cmd, uint8_t r, uint8_t g, uint8_t b)
 {	
 	// Write data to the slave : address pointer
 	minm_i2c_buf[0] = cmd;
@@ -90,14 +88,8 @@ void i2c_write_minm_rgb(uint8_t cmd, uint8_t r, uint8_t g, uint8_t b)
 	minm_i2c_buf[2] = g;
 	minm_i2c_buf[3] = b;
 	
-	I2C_0_MasterClearStatus();
-	//I2C_0_MasterClearWriteBuf();
-    I2C_0_MasterWriteBuf(I2C_SLAVE_ADDR_MINM, (uint8_t *) minm_i2c_buf,
-                             4, I2C_0_MODE_COMPLETE_XFER);
-
 	//ISR will take it from here...
-	
-	return;	
+	return i2c0_write(I2C_SLAVE_ADDR_MINM, minm_i2c_buf, 4);
 }
 
 //One byte encodes the colors: 0 = Off, 1 = Red, 2 = Green, 3 = Blue, 4 = White
@@ -127,7 +119,8 @@ void minm_byte_to_rgb(uint8_t byte, uint8_t *r, uint8_t *g, uint8_t *b)
 }
 
 //Updates the MinM LED if the color changed, otherwise does noting.
-//Returns 0 when nothing changed (no I2C transfer), 1 when it's using the bus
+//Returns 0 when nothing changed (no I2C transfer), 1 when it's using the bus.
+//If the I2C0 queue is busy we'll try again at the next call.
 uint8_t update_minm_rgb(void)
 {
 	uint8_t retval = 0;
@@ -140,12 +133,13 @@ uint8_t update_minm_rgb(void)
 		//Color changed.
 		
 		minm_byte_to_rgb(minm_rgb_color, &r, &g, &b);
-		i2c_write_minm_rgb(SET_RGB, r, g, b);
-		retval = 1;
+		if(i2c_write_minm_rgb(SET_RGB, r, g, b) == 0)
+		{
+			last_minm_rgb_color = minm_rgb_color;
+			retval = 1;
+		}
 	}
 	
-	last_minm_rgb_color = minm_rgb_color;
-	
 	#endif	//USE_I2C_0
 	
 	return retval;
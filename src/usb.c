@@ -41,6 +41,7 @@
 #include "flexsea_board.h"
 #include <flexsea_comm.h>
 #include <flexsea_comm_multi.h>
+#include <string.h>
 
 //****************************************************************************
 // Variable(s)
@@ -49,8 +50,17 @@
 uint8_t buffer[RX_BUF_LEN];
 uint8_t usbConnected = 0;
 
+struct usb_tx_s usbTx;
+static uint8_t usbTxPacket[USB_TX_PACKET_LEN];
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static uint8_t usb_tx_host(void);
+
 //****************************************************************************
-// Function(s)
+// Public Function(s)
 //****************************************************************************
 
 //Initialize the USB peripheral
@@ -116,15 +126,110 @@ void get_usb_data(void)
 	}
 }
 
-//Sends a fixed length packet over USB. Discarded if USB isn't ready.
+//Sends a packet right away if nothing is waiting and the endpoint is free,
+//otherwise it's copied in the queue. Returns 0 (discarded) if the queue is full
+//or if the host isn't there.
 uint8_t usb_puts(uint8_t *buf, uint32 len)
 {
-	if(USBUART_1_CDCIsReady() != 0)
+	uint16_t free = 0, first = 0;
+	
+	if(!len)
+	{
+		return 1;
+	}
+	
+	if(!usb_tx_host())
+	{
+		return 0;
+	}
+	
+	//The USB block copies it, no need to queue:
+	if((usbTx.head == usbTx.tail) && (len <= USB_TX_PACKET_LEN) && \
+		(USBUART_1_CDCIsReady() != 0))
+	{
+		USBUART_1_PutData((const uint8_t*)buf, (uint16)len);
+		usbTx.zlp = (len == USB_TX_PACKET_LEN);
+		usbTx.packets++;
+		usbTx.bytes += len;
+		return 1;
+	}
+	
+	free = (usbTx.tail - usbTx.head - 1) & USB_TX_QUEUE_MASK;
+	if(len > free)
+	{
+		usbTx.dropped++;
+		return 0;
+	}
+	
+	first = USB_TX_QUEUE_LEN - usbTx.head;
+	if(first > len) {first = (uint16_t)len;}
+	memcpy(&usbTx.buf[usbTx.head], buf, first);
+	memcpy(usbTx.buf, buf + first, len - first);
+	usbTx.head = (usbTx.head + len) & USB_TX_QUEUE_MASK;
+	
+	usb_tx_service();
+	return 1;
+}
+
+//Call at 10kHz. One USB packet per call, straight from the queue when it
+//doesn't wrap around.
+void usb_tx_service(void)
+{
+	uint16_t n = 0, first = 0;
+	
+	if(((usbTx.head == usbTx.tail) && !usbTx.zlp) || !usb_tx_host() || \
+		(USBUART_1_CDCIsReady() == 0))
+	{
+		return;
+	}
+	
+	//A full packet doesn't end a bulk transfer: the host would wait for more
+	if(usbTx.head == usbTx.tail)
+	{
+		USBUART_1_PutData(NULL, 0);
+		usbTx.zlp = 0;
+		return;
+	}
+	
+	n = (usbTx.head - usbTx.tail) & USB_TX_QUEUE_MASK;
+	if(n > USB_TX_PACKET_LEN) {n = USB_TX_PACKET_LEN;}
+	first = USB_TX_QUEUE_LEN - usbTx.tail;
+	
+	if(n <= first)
+	{
+		USBUART_1_PutData((const uint8_t*)&usbTx.buf[usbTx.tail], n);
+	}
+	else
+	{
+		//CDC is a byte stream, frames can span two USB packets:
+		memcpy(usbTxPacket, &usbTx.buf[usbTx.tail], first);
+		memcpy(&usbTxPacket[first], usbTx.buf, n - first);
+		USBUART_1_PutData((const uint8_t*)usbTxPacket, n);
+	}
+	
+	usbTx.tail = (usbTx.tail + n) & USB_TX_QUEUE_MASK;
+	usbTx.zlp = (n == USB_TX_PACKET_LEN);
+	usbTx.packets++;
+	usbTx.bytes += n;
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+//Host still there? If not, the queue is flushed (stale replies) and
+//usbRuntimeConnect() will re-init the CDC when it's back.
+static uint8_t usb_tx_host(void)
+{
+	if(usbConnected && USBUART_1_GetConfiguration())
 	{
-		USBUART_1_PutData(( const uint8_t*)buf, len);
 		return 1;
 	}
 	
+	usbConnected = 0;
+	usbTx.flushed += (usbTx.head - usbTx.tail) & USB_TX_QUEUE_MASK;
+	usbTx.tail = usbTx.head;
+	usbTx.zlp = 0;
 	return 0;
 }
 